@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../tim_sort.hpp"
+
+enum class Input : int64_t {
+  kRandom,
+  kSorted,
+  kNearlySorted,
+  kReversed,
+};
+
+// kNearlySorted: sorted, then 1% of positions take part in random swaps
+std::vector<int64_t> ConstructVector(int sz, Input input) {
+  std::random_device rd;
+  std::mt19937_64 mt(rd());
+  std::vector<int64_t> res(sz);
+  for (auto& val : res) {
+    val = static_cast<int64_t>(mt());
+  }
+
+  switch (input) {
+    case Input::kRandom:
+      break;
+    case Input::kSorted:
+      std::sort(res.begin(), res.end());
+      break;
+    case Input::kNearlySorted:
+      std::sort(res.begin(), res.end());
+      for (int i = 0; i < sz / 200; ++i) {
+        std::swap(res[mt() % sz], res[mt() % sz]);
+      }
+      break;
+    case Input::kReversed:
+      std::sort(res.begin(), res.end(), std::greater<>());
+      break;
+  }
+  return res;
+}
+
+// Args: size, input kind
+template <typename Sort>
+void RunSort(benchmark::State& state, Sort sort) {
+  auto values = ConstructVector(state.range(0), static_cast<Input>(state.range(1)));
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    sort(copy.begin(), copy.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void BM_TimSort(benchmark::State& state) {
+  RunSort(state, [](auto first, auto last) { TimSort(first, last); });
+}
+
+void BM_StdSort(benchmark::State& state) {
+  RunSort(state, [](auto first, auto last) { std::sort(first, last); });
+}
+
+void BM_StdStableSort(benchmark::State& state) {
+  RunSort(state, [](auto first, auto last) { std::stable_sort(first, last); });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lists: values go through a buffer, nodes are relinked by SortChain
+// and by std::list::sort
+void BM_TimSortList(benchmark::State& state) {
+  auto values = ConstructVector(state.range(0), static_cast<Input>(state.range(1)));
+  std::list<int64_t> list;
+  for (auto _ : state) {
+    state.PauseTiming();
+    list.assign(values.begin(), values.end());
+    state.ResumeTiming();
+    TimSort(list.begin(), list.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+struct ChainNode {
+  int64_t value;
+  ChainNode* next;
+};
+
+void BM_SortChain(benchmark::State& state) {
+  auto values = ConstructVector(state.range(0), static_cast<Input>(state.range(1)));
+  std::vector<ChainNode> nodes(values.size());
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      nodes[i] = {values[i], i + 1 < nodes.size() ? &nodes[i + 1] : nullptr};
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(SortChain(&nodes[0], &ChainNode::next, &ChainNode::value));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdListSort(benchmark::State& state) {
+  auto values = ConstructVector(state.range(0), static_cast<Input>(state.range(1)));
+  std::list<int64_t> list;
+  for (auto _ : state) {
+    state.PauseTiming();
+    list.assign(values.begin(), values.end());
+    state.ResumeTiming();
+    list.sort();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+const std::vector<int64_t> kInputs{
+    static_cast<int64_t>(Input::kRandom),
+    static_cast<int64_t>(Input::kSorted),
+    static_cast<int64_t>(Input::kNearlySorted),
+    static_cast<int64_t>(Input::kReversed),
+};
+
+BENCHMARK(BM_TimSort)->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, kInputs})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdSort)->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, kInputs})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdStableSort)->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, kInputs})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TimSortList)->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, kInputs})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SortChain)->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, kInputs})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdListSort)->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, kInputs})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <forward_list>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../tim_sort.hpp"
+
+// (key, position in the input): sorting by key only shows stability
+using Item = std::pair<int, size_t>;
+
+bool ByKey(const Item& a, const Item& b) {
+  return a.first < b.first;
+}
+
+std::vector<Item> RandomItems(size_t sz, int max_key, uint32_t seed = 42) {
+  std::mt19937 mt(seed);
+  std::vector<Item> res(sz);
+  for (size_t i = 0; i < sz; ++i) {
+    res[i] = {static_cast<int>(mt() % max_key), i};
+  }
+  return res;
+}
+
+void ExpectStableSorted(const std::vector<Item>& values) {
+  auto expected = values;
+  std::stable_sort(expected.begin(), expected.end(), ByKey);
+
+  auto sorted = values;
+  TimSort(sorted.begin(), sorted.end(), ByKey);
+  ASSERT_EQ(sorted, expected);
+}
+
+// Sorted input with `swaps` random transpositions
+std::vector<Item> NearlySorted(size_t sz, size_t swaps, uint32_t seed = 42) {
+  std::mt19937 mt(seed);
+  std::vector<Item> res(sz);
+  for (size_t i = 0; i < sz; ++i) {
+    res[i] = {static_cast<int>(i / 3), i};
+  }
+  for (size_t i = 0; i < swaps; ++i) {
+    std::swap(res[mt() % sz], res[mt() % sz]);
+  }
+  return res;
+}
+
+
+TEST(TimSortTest, Empty) {
+  std::vector<int> values;
+  TimSort(values.begin(), values.end());
+  ASSERT_TRUE(values.empty());
+}
+
+TEST(TimSortTest, Simple) {
+  std::vector<int> values{5, 3, 9, 1, 0, 7, 3};
+  TimSort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<int>{0, 1, 3, 3, 5, 7, 9}));
+}
+
+TEST(TimSortTest, AllSmallSizes) {
+  for (size_t sz = 0; sz < 300; ++sz) {
+    ExpectStableSorted(RandomItems(sz, 10, static_cast<uint32_t>(sz)));
+  }
+}
+
+TEST(TimSortTest, RandomStable) {
+  ExpectStableSorted(RandomItems(100000, 100));
+  ExpectStableSorted(RandomItems(100000, 1000000));
+}
+
+TEST(TimSortTest, NearlySorted) {
+  ExpectStableSorted(NearlySorted(100000, 0));
+  ExpectStableSorted(NearlySorted(100000, 10));
+  ExpectStableSorted(NearlySorted(100000, 1000));
+}
+
+TEST(TimSortTest, ReversedAndDescendingRuns) {
+  std::vector<Item> values;
+  for (size_t i = 0; i < 50000; ++i) {
+    values.push_back({static_cast<int>(50000 - i / 2), i});
+  }
+  ExpectStableSorted(values);
+
+  // Saw: many descending runs of different length
+  values.clear();
+  for (size_t run = 0; run < 500; ++run) {
+    for (size_t i = 0; i < run % 137 + 1; ++i) {
+      values.push_back({static_cast<int>(1000 - i), values.size()});
+    }
+  }
+  ExpectStableSorted(values);
+}
+
+TEST(TimSortTest, BlockyData) {
+  // Interleaving long sorted blocks is where galloping kicks in
+  std::vector<Item> values;
+  for (size_t block = 0; block < 64; ++block) {
+    int start = static_cast<int>((block * 7919) % 64) * 1000;
+    for (int i = 0; i < 1000; ++i) {
+      values.push_back({start + i, values.size()});
+    }
+  }
+  ExpectStableSorted(values);
+}
+
+TEST(TimSortTest, Comparator) {
+  std::mt19937 mt(42);
+  std::vector<std::string> values(10000);
+  for (auto& str : values) {
+    str = std::to_string(mt() % 5000);
+  }
+  auto expected = values;
+  std::stable_sort(expected.begin(), expected.end(), std::greater<>());
+  TimSort(values.begin(), values.end(), std::greater<>());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(TimSortTest, ForwardIterators) {
+  auto items = RandomItems(10000, 50);
+  auto expected = items;
+  std::stable_sort(expected.begin(), expected.end(), ByKey);
+
+  std::forward_list<Item> forward(items.begin(), items.end());
+  TimSort(forward.begin(), forward.end(), ByKey);
+  ASSERT_TRUE(std::equal(forward.begin(), forward.end(), expected.begin(), expected.end()));
+
+  std::list<Item> list(items.begin(), items.end());
+  TimSort(list.begin(), list.end(), ByKey);
+  ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+}
+
+// Minimal stand-in for the course lists: only Begin() / End() are used
+template <typename T>
+struct CourseListLike {
+  std::list<T> values;
+
+  auto Begin() { return values.begin(); }
+  auto End() { return values.end(); }
+};
+
+TEST(TimSortTest, SortList) {
+  CourseListLike<int> list{{3, 1, 2, 5, 4}};
+  SortList(list);
+  ASSERT_EQ(list.values, (std::list<int>{1, 2, 3, 4, 5}));
+}
+
+// Shaped like the course ForwardList: nodes are private, the list sorts them
+// itself by relinking
+template <typename T>
+class CourseForwardList {
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+public:
+  class Iterator {
+  public:
+    explicit Iterator(Node* current) : current_(current) {}
+
+    T& operator*() const { return current_->value; }
+    Iterator& operator++() {
+      current_ = current_->next;
+      return *this;
+    }
+    bool operator==(const Iterator&) const = default;
+
+  private:
+    Node* current_;
+  };
+
+  CourseForwardList(std::initializer_list<T> values) {
+    Node** tail = &head_;
+    for (const auto& value : values) {
+      *tail = new Node{value, nullptr};
+      tail = &(*tail)->next;
+    }
+  }
+
+  CourseForwardList(const CourseForwardList&) = delete;
+  CourseForwardList& operator=(const CourseForwardList&) = delete;
+
+  Iterator Begin() const { return Iterator(head_); }
+  Iterator End() const { return Iterator(nullptr); }
+
+  template <typename Compare>
+  void Sort(Compare comp) {
+    head_ = SortChain(head_, &Node::next, &Node::value, comp);
+  }
+
+  ~CourseForwardList() {
+    while (head_ != nullptr) {
+      delete std::exchange(head_, head_->next);
+    }
+  }
+
+private:
+  Node* head_ = nullptr;
+};
+
+// Shaped like the course List: a ring through the fake node
+template <typename T>
+class CourseList {
+  struct Node {
+    Node* prev;
+    Node* next;
+    T value;
+  };
+
+public:
+  CourseList(std::initializer_list<T> values) {
+    for (const auto& value : values) {
+      Node* node = new Node{fake_.prev, &fake_, value};
+      fake_.prev->next = node;
+      fake_.prev = node;
+    }
+  }
+
+  CourseList(const CourseList&) = delete;
+  CourseList& operator=(const CourseList&) = delete;
+
+  // The ring is cut at the fake node, the chain is sorted and the back
+  // links are restored in one pass
+  template <typename Compare>
+  void Sort(Compare comp) {
+    if (fake_.next == &fake_) {
+      return;
+    }
+    fake_.prev->next = nullptr;
+    fake_.next = SortChain(fake_.next, &Node::next, &Node::value, comp);
+
+    Node* prev = &fake_;
+    for (Node* node = fake_.next; node != nullptr; node = node->next) {
+      node->prev = prev;
+      prev = node;
+    }
+    prev->next = &fake_;
+    fake_.prev = prev;
+  }
+
+  std::vector<T> Forward() const {
+    std::vector<T> res;
+    for (const Node* node = fake_.next; node != &fake_; node = node->next) {
+      res.push_back(node->value);
+    }
+    return res;
+  }
+
+  std::vector<T> Backward() const {
+    std::vector<T> res;
+    for (const Node* node = fake_.prev; node != &fake_; node = node->prev) {
+      res.push_back(node->value);
+    }
+    return res;
+  }
+
+  std::vector<const T*> Addresses() const {
+    std::vector<const T*> res;
+    for (const Node* node = fake_.next; node != &fake_; node = node->next) {
+      res.push_back(&node->value);
+    }
+    return res;
+  }
+
+  ~CourseList() {
+    for (Node* node = fake_.next; node != &fake_;) {
+      delete std::exchange(node, node->next);
+    }
+  }
+
+private:
+  Node fake_{&fake_, &fake_, T()};
+};
+
+struct ChainNode {
+  Item value;
+  ChainNode* next;
+};
+
+void ExpectChainStableSorted(const std::vector<Item>& values) {
+  std::vector<ChainNode> nodes(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    nodes[i] = {values[i], i + 1 < values.size() ? &nodes[i + 1] : nullptr};
+  }
+  ChainNode* head = SortChain(values.empty() ? nullptr : &nodes[0], &ChainNode::next, &ChainNode::value, ByKey);
+
+  auto expected = values;
+  std::stable_sort(expected.begin(), expected.end(), ByKey);
+  std::vector<Item> sorted;
+  for (; head != nullptr; head = head->next) {
+    sorted.push_back(head->value);
+  }
+  ASSERT_EQ(sorted, expected);
+}
+
+TEST(SortChainTest, Stable) {
+  for (size_t sz = 0; sz < 100; ++sz) {
+    ExpectChainStableSorted(RandomItems(sz, 5, static_cast<uint32_t>(sz)));
+  }
+  ExpectChainStableSorted(RandomItems(100000, 100));
+  ExpectChainStableSorted(RandomItems(100000, 1000000));
+}
+
+TEST(SortChainTest, Runs) {
+  ExpectChainStableSorted(NearlySorted(100000, 0));
+  ExpectChainStableSorted(NearlySorted(100000, 100));
+
+  // Descending runs with equal neighbours stay stable
+  std::vector<Item> values;
+  for (size_t run = 0; run < 500; ++run) {
+    for (size_t i = 0; i < run % 37 + 1; ++i) {
+      values.push_back({static_cast<int>(100 - i / 2), values.size()});
+    }
+  }
+  ExpectChainStableSorted(values);
+}
+
+TEST(SortChainTest, Lambdas) {
+  std::vector<ChainNode> nodes{{{3, 0}, nullptr}, {{1, 1}, nullptr}, {{2, 2}, nullptr}};
+  nodes[0].next = &nodes[1];
+  nodes[1].next = &nodes[2];
+  auto next = [](ChainNode* node) -> ChainNode*& { return node->next; };
+  auto key = [](ChainNode* node) { return node->value.first; };
+  ChainNode* head = SortChain(&nodes[0], next, key, std::greater<>());
+  ASSERT_EQ(head, &nodes[0]);
+  ASSERT_EQ(head->next, &nodes[2]);
+  ASSERT_EQ(head->next->next, &nodes[1]);
+  ASSERT_EQ(nodes[1].next, nullptr);
+}
+
+TEST(SortChainTest, CourseForwardList) {
+  CourseForwardList<int> list{5, 3, 9, 1, 0, 7, 3};
+  SortList(list);
+  std::vector<int> sorted;
+  for (auto it = list.Begin(); it != list.End(); ++it) {
+    sorted.push_back(*it);
+  }
+  ASSERT_EQ(sorted, (std::vector<int>{0, 1, 3, 3, 5, 7, 9}));
+
+  CourseForwardList<int> empty{};
+  SortList(empty, std::greater<>());
+  ASSERT_EQ(empty.Begin(), empty.End());
+}
+
+TEST(SortChainTest, CourseList) {
+  CourseList<int> list{4, 8, 1, 1, 6, 2};
+  auto addresses = list.Addresses();
+  SortList(list, std::greater<>());
+  ASSERT_EQ(list.Forward(), (std::vector<int>{8, 6, 4, 2, 1, 1}));
+  ASSERT_EQ(list.Backward(), (std::vector<int>{1, 1, 2, 4, 6, 8}));
+
+  // Nodes are relinked, elements stay where they were
+  auto sorted_addresses = list.Addresses();
+  std::sort(addresses.begin(), addresses.end());
+  std::sort(sorted_addresses.begin(), sorted_addresses.end());
+  ASSERT_EQ(addresses, sorted_addresses);
+}
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
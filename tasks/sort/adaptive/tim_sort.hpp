@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail::tim_sort {
+
+// Runs shorter than this are extended by binary insertion sort
+inline constexpr size_t kMinMerge = 64;
+
+// Initial number of consecutive wins of one run that switches merge to galloping
+inline constexpr size_t kMinGallop = 7;
+
+// Minimal run length in [kMinMerge / 2, kMinMerge], chosen so that
+// size / minrun is a power of two or slightly less: then merges stay balanced
+inline size_t MinRunLength(size_t size) noexcept {
+    size_t low_bits = 0;
+    while (size >= kMinMerge) {
+        low_bits |= size & 1;
+        size >>= 1;
+    }
+    return size + low_bits;
+}
+
+// Length of the run starting at first. A strictly descending run is reversed
+// in place; strictness keeps equal elements in their order.
+template <typename RandomIt, typename Compare>
+size_t CountRunAndMakeAscending(RandomIt first, RandomIt last, Compare& comp) {
+    RandomIt it = std::next(first);
+    if (it == last) {
+        return 1;
+    }
+
+    if (comp(*it, *first)) {
+        while (std::next(it) != last && comp(*std::next(it), *it)) {
+            ++it;
+        }
+        ++it;
+        std::reverse(first, it);
+    } else {
+        while (std::next(it) != last && !comp(*std::next(it), *it)) {
+            ++it;
+        }
+        ++it;
+    }
+
+    return std::distance(first, it);
+}
+
+// Sorts [first, last) knowing that [first, sorted) is already sorted
+template <typename RandomIt, typename Compare>
+void BinaryInsertionSort(RandomIt first, RandomIt last, RandomIt sorted, Compare& comp) {
+    for (RandomIt it = sorted; it != last; ++it) {
+        auto pivot = std::move(*it);
+        RandomIt pos = std::upper_bound(first, it, pivot, comp);
+        std::move_backward(pos, it, std::next(it));
+        *pos = std::move(pivot);
+    }
+}
+
+// Number of elements of sorted [first, first + size) that are not greater than key.
+// Exponential search from the beginning, then binary search: O(log k) for answer k.
+template <typename T, typename RandomIt, typename Compare>
+size_t GallopRight(const T& key, RandomIt first, size_t size, Compare& comp) {
+    size_t lo = 0;
+    size_t hi = 1;
+    while (hi <= size && !comp(key, first[hi - 1])) {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    hi = std::min(hi, size);
+    return lo + (std::upper_bound(first + lo, first + hi, key, comp) - (first + lo));
+}
+
+// Number of elements of sorted [first, first + size) that are less than key
+template <typename T, typename RandomIt, typename Compare>
+size_t GallopLeft(const T& key, RandomIt first, size_t size, Compare& comp) {
+    size_t lo = 0;
+    size_t hi = 1;
+    while (hi <= size && comp(first[hi - 1], key)) {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    hi = std::min(hi, size);
+    return lo + (std::lower_bound(first + lo, first + hi, key, comp) - (first + lo));
+}
+
+// Stable merge of adjacent runs [base, base + len_a) and [base + len_a, base + len_a + len_b),
+// the first one is moved to tmp. Elements are taken one by one until one run
+// wins min_gallop times in a row; then whole blocks are found by galloping.
+// Merge from the right end is this function on reverse iterators with the
+// flipped comparator.
+template <typename RandomIt, typename Buffer, typename Compare>
+void MergeLo(RandomIt base, size_t len_a, size_t len_b, Buffer& tmp, size_t& min_gallop, Compare& comp) {
+    tmp.assign(std::make_move_iterator(base), std::make_move_iterator(base + len_a));
+
+    auto a = tmp.begin();
+    auto a_end = tmp.end();
+    RandomIt b = base + len_a;
+    RandomIt b_end = b + len_b;
+    RandomIt dest = base;
+
+    while (a != a_end && b != b_end) {
+        size_t wins_a = 0;
+        size_t wins_b = 0;
+
+        // One-at-a-time mode
+        while (a != a_end && b != b_end) {
+            if (comp(*b, *a)) {
+                *dest++ = std::move(*b++);
+                wins_a = 0;
+                if (++wins_b >= min_gallop) {
+                    break;
+                }
+            } else {
+                *dest++ = std::move(*a++);
+                wins_b = 0;
+                if (++wins_a >= min_gallop) {
+                    break;
+                }
+            }
+        }
+
+        // Galloping mode: stays while it keeps finding long blocks
+        while (a != a_end && b != b_end) {
+            size_t block_a = GallopRight(*b, a, a_end - a, comp);
+            dest = std::move(a, a + block_a, dest);
+            a += block_a;
+            if (a == a_end) {
+                break;
+            }
+            *dest++ = std::move(*b++);
+            if (b == b_end) {
+                break;
+            }
+
+            size_t block_b = GallopLeft(*a, b, b_end - b, comp);
+            dest = std::move(b, b + block_b, dest);
+            b += block_b;
+            if (b == b_end) {
+                break;
+            }
+            *dest++ = std::move(*a++);
+
+            if (min_gallop > 1) {
+                --min_gallop;
+            }
+            if (block_a < kMinGallop && block_b < kMinGallop) {
+                // Data is not blocky: leaving galloping gets more expensive
+                min_gallop += 2;
+                break;
+            }
+        }
+    }
+
+    // Rest of the second run is already in place
+    std::move(a, a_end, dest);
+}
+
+template <typename Compare>
+struct Flipped {
+    Compare& comp;
+
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+        return comp(b, a);
+    }
+};
+
+template <typename RandomIt, typename Compare>
+class TimSorter {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+
+    struct Run {
+        size_t base;
+        size_t len;
+    };
+
+public:
+    TimSorter(RandomIt first, Compare& comp) : first_(first), comp_(comp) {
+    }
+
+    void Sort(size_t size) {
+        size_t min_run = MinRunLength(size);
+
+        for (size_t lo = 0; lo < size;) {
+            size_t len = CountRunAndMakeAscending(first_ + lo, first_ + size, comp_);
+
+            if (len < min_run) {
+                size_t forced = std::min(min_run, size - lo);
+                BinaryInsertionSort(first_ + lo, first_ + lo + forced, first_ + lo + len, comp_);
+                len = forced;
+            }
+
+            runs_.push_back({lo, len});
+            MergeCollapse();
+            lo += len;
+        }
+
+        while (runs_.size() > 1) {
+            size_t n = runs_.size() - 2;
+            if (n > 0 && runs_[n - 1].len < runs_[n + 1].len) {
+                --n;
+            }
+            MergeAt(n);
+        }
+    }
+
+private:
+    // Keeps run lengths on the stack growing at least like Fibonacci numbers
+    // (checked for the top four runs, not three: the three-run check
+    // of the original TimSort can be broken by a deep merge)
+    void MergeCollapse() {
+        while (runs_.size() > 1) {
+            size_t n = runs_.size() - 2;
+            if ((n > 0 && runs_[n - 1].len <= runs_[n].len + runs_[n + 1].len) ||
+                (n > 1 && runs_[n - 2].len <= runs_[n - 1].len + runs_[n].len)) {
+                if (runs_[n - 1].len < runs_[n + 1].len) {
+                    --n;
+                }
+            } else if (runs_[n].len > runs_[n + 1].len) {
+                break;
+            }
+            MergeAt(n);
+        }
+    }
+
+    void MergeAt(size_t i) {
+        size_t base = runs_[i].base;
+        size_t len_a = runs_[i].len;
+        size_t len_b = runs_[i + 1].len;
+
+        runs_[i].len = len_a + len_b;
+        runs_.erase(runs_.begin() + i + 1);
+
+        RandomIt a = first_ + base;
+        RandomIt b = a + len_a;
+
+        // Head of the first run not greater than the second run is in place
+        size_t skip = GallopRight(*b, a, len_a, comp_);
+        a += skip;
+        len_a -= skip;
+        if (len_a == 0) {
+            return;
+        }
+
+        // Tail of the second run not less than the first run is in place
+        len_b = GallopLeft(*(b - 1), b, len_b, comp_);
+        if (len_b == 0) {
+            return;
+        }
+
+        // The shorter run goes to the buffer
+        if (len_a <= len_b) {
+            MergeLo(a, len_a, len_b, tmp_, min_gallop_, comp_);
+        } else {
+            auto reversed = std::make_reverse_iterator(b + len_b);
+            Flipped<Compare> flipped{comp_};
+            MergeLo(reversed, len_b, len_a, tmp_, min_gallop_, flipped);
+        }
+    }
+
+private:
+    RandomIt first_;
+    Compare& comp_;
+    std::vector<Run> runs_;
+    std::vector<T> tmp_;
+    size_t min_gallop_ = kMinGallop;
+};
+
+// Singly linked chains of nodes: Next(node) is the Node*& link, nullptr
+// ends a chain, Value(node) is the element. Both go through std::invoke,
+// so member pointers like &Node::next work.
+
+// Cuts the run at the head of rest off and returns it, rest moves past it.
+// A strictly descending run is reversed by relinking.
+template <typename Node, typename Next, typename Value, typename Compare>
+Node* TakeRun(Node*& rest, Next& next, Value& value, Compare& comp) {
+    Node* run = rest;
+    Node* last = rest;
+    Node* curr = std::invoke(next, last);
+
+    if (curr != nullptr && comp(std::invoke(value, curr), std::invoke(value, last))) {
+        std::invoke(next, run) = nullptr;
+        while (curr != nullptr && comp(std::invoke(value, curr), std::invoke(value, last))) {
+            Node* after = std::invoke(next, curr);
+            std::invoke(next, curr) = run;
+            run = curr;
+            last = curr;
+            curr = after;
+        }
+    } else {
+        while (curr != nullptr && !comp(std::invoke(value, curr), std::invoke(value, last))) {
+            last = curr;
+            curr = std::invoke(next, curr);
+        }
+        std::invoke(next, last) = nullptr;
+    }
+
+    rest = curr;
+    return run;
+}
+
+// Stable merge of two chains, elements of the first one go first on ties
+template <typename Node, typename Next, typename Value, typename Compare>
+Node* MergeChains(Node* first, Node* second, Next& next, Value& value, Compare& comp) {
+    Node* head = nullptr;
+    Node** tail = &head;
+    while (first != nullptr && second != nullptr) {
+        Node*& taken = comp(std::invoke(value, second), std::invoke(value, first)) ? second : first;
+        *tail = taken;
+        tail = &std::invoke(next, taken);
+        taken = *tail;
+    }
+    *tail = (first != nullptr) ? first : second;
+    return head;
+}
+
+}  // namespace detail::tim_sort
+
+// Stable adaptive merge sort (TimSort).
+//
+// Finds runs that are already sorted (descending ones are reversed), extends
+// short runs to minrun by binary insertion sort and merges runs with
+// galloping. Sorted or nearly sorted input costs O(n), random input
+// O(n log n). Needs at most n / 2 elements of additional memory.
+//
+// Ranges without random access are moved into a buffer, sorted there and
+// moved back. Lists that own their nodes relink them instead, see SortChain.
+template <typename ForwardIt, typename Compare = std::less<>>
+void TimSort(ForwardIt first, ForwardIt last, Compare comp = Compare()) {
+    using Category = typename std::iterator_traits<ForwardIt>::iterator_category;
+    using T = typename std::iterator_traits<ForwardIt>::value_type;
+
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag, Category>) {
+        size_t size = std::distance(first, last);
+        if (size < 2) {
+            return;
+        }
+
+        if (size < detail::tim_sort::kMinMerge) {
+            size_t len = detail::tim_sort::CountRunAndMakeAscending(first, last, comp);
+            detail::tim_sort::BinaryInsertionSort(first, last, first + len, comp);
+            return;
+        }
+
+        detail::tim_sort::TimSorter<ForwardIt, Compare>(first, comp).Sort(size);
+    } else {
+        std::vector<T> buffer(std::make_move_iterator(first), std::make_move_iterator(last));
+        TimSort(buffer.begin(), buffer.end(), comp);
+        std::move(buffer.begin(), buffer.end(), first);
+    }
+}
+
+// Stable natural merge sort of a singly linked chain by relinking nodes:
+// no element is moved or copied and extra memory is O(1).
+//
+// Runs are found like in TimSort (strictly descending ones are reversed)
+// and merged bottom-up: pending[k] holds 2^k merged runs, a new run is
+// carried up like a bit of a binary counter. A sorted chain or one of
+// a few runs costs O(n), any chain O(n log n). Returns the new head.
+//
+// Doubly linked lists fix their back links in one more pass.
+template <typename Node, typename Next, typename Value, typename Compare = std::less<>>
+Node* SortChain(Node* head, Next next, Value value, Compare comp = Compare()) {
+    // 64 levels hold up to 2^64 runs
+    Node* pending[64] = {};
+    size_t levels = 0;
+
+    while (head != nullptr) {
+        Node* carry = detail::tim_sort::TakeRun(head, next, value, comp);
+        size_t level = 0;
+        for (; pending[level] != nullptr; ++level) {
+            carry = detail::tim_sort::MergeChains(pending[level], carry, next, value, comp);
+            pending[level] = nullptr;
+        }
+        pending[level] = carry;
+        levels = std::max(levels, level + 1);
+    }
+
+    // Higher levels hold earlier runs
+    Node* result = nullptr;
+    for (size_t level = 0; level < levels; ++level) {
+        if (pending[level] != nullptr) {
+            result = (result == nullptr) ? pending[level]
+                                         : detail::tim_sort::MergeChains(pending[level], result, next, value, comp);
+        }
+    }
+    return result;
+}
+
+// Entry point for the course lists. A list with Sort(comp) sorts its own
+// nodes with SortChain; anything else with Begin() / End() goes through TimSort
+template <typename List, typename Compare = std::less<>>
+void SortList(List& list, Compare comp = Compare()) {
+    if constexpr (requires { list.Sort(comp); }) {
+        list.Sort(comp);
+    } else {
+        TimSort(list.Begin(), list.End(), comp);
+    }
+}
@@ -0,0 +1,455 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail::external {
+
+// Smallest block a run reader may get: below this the merge degenerates
+// into seeks, so the fan-in is reduced and an extra merge pass is made
+inline constexpr size_t kMinBlockBytes = 4096;
+
+class File {
+public:
+    File(const std::filesystem::path& path, int flags) : path_(path) {
+        fd_ = ::open(path.c_str(), flags, 0644);  // NOLINT
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Can't open " + path.string());
+        }
+    }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File() {
+        ::close(fd_);
+    }
+
+    // Reads until `bytes` are read or the file ends, returns the number of bytes read
+    size_t Read(void* data, size_t bytes) const {
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t res = ::read(fd_, static_cast<char*>(data) + done, bytes - done);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0) {
+                throw std::system_error(errno, std::generic_category(), "Can't read " + path_.string());
+            }
+            if (res == 0) {
+                break;
+            }
+            done += res;
+        }
+        return done;
+    }
+
+    void Write(const void* data, size_t bytes) const {
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t res = ::write(fd_, static_cast<const char*>(data) + done, bytes - done);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0) {
+                throw std::system_error(errno, std::generic_category(), "Can't write " + path_.string());
+            }
+            done += res;
+        }
+    }
+
+private:
+    std::filesystem::path path_;
+    int fd_;
+};
+
+// Sequential reader of a sorted run with double buffering: while the merge
+// consumes one block, the next one is read in the background
+template <typename Record>
+class RunReader {
+public:
+    RunReader(const std::filesystem::path& path, size_t block_records)
+        : file_(path, O_RDONLY), front_(block_records), back_(block_records) {
+        size_ = ReadBlock(front_);
+        Prefetch();
+    }
+
+    RunReader(const RunReader&) = delete;
+    RunReader& operator=(const RunReader&) = delete;
+
+    ~RunReader() {
+        if (pending_.valid()) {
+            pending_.wait();
+        }
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return pos_ == size_;
+    }
+
+    inline const Record& Current() const noexcept {
+        return front_[pos_];
+    }
+
+    void Advance() {
+        if (++pos_ < size_) {
+            return;
+        }
+
+        size_ = pending_.get();
+        pos_ = 0;
+        std::swap(front_, back_);
+        if (size_ != 0) {
+            Prefetch();
+        }
+    }
+
+private:
+    size_t ReadBlock(std::vector<Record>& block) {
+        size_t bytes = file_.Read(block.data(), block.size() * sizeof(Record));
+        return bytes / sizeof(Record);
+    }
+
+    void Prefetch() {
+        pending_ = std::async(std::launch::async, [this] {
+            return ReadBlock(back_);
+        });
+    }
+
+private:
+    File file_;
+    std::vector<Record> front_;
+    std::vector<Record> back_;
+    size_t pos_ = 0;
+    size_t size_ = 0;
+    std::future<size_t> pending_;
+};
+
+// Sequential writer with double buffering: a full block is written
+// in the background while the next one is being filled
+template <typename Record>
+class RunWriter {
+public:
+    RunWriter(const std::filesystem::path& path, size_t block_records)
+        : file_(path, O_WRONLY | O_CREAT | O_TRUNC), front_(block_records), back_(block_records) {
+    }
+
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+
+    ~RunWriter() {
+        if (pending_.valid()) {
+            pending_.wait();
+        }
+    }
+
+    void Push(const Record& record) {
+        front_[size_++] = record;
+        if (size_ == front_.size()) {
+            Flush();
+        }
+    }
+
+    // Writes everything pushed so far and waits for the disk
+    void Finish() {
+        Flush();
+        if (pending_.valid()) {
+            pending_.get();
+        }
+    }
+
+private:
+    void Flush() {
+        if (pending_.valid()) {
+            pending_.get();
+        }
+        if (size_ == 0) {
+            return;
+        }
+
+        std::swap(front_, back_);
+        pending_ = std::async(std::launch::async, [this, bytes = size_ * sizeof(Record)] {
+            file_.Write(back_.data(), bytes);
+        });
+        size_ = 0;
+    }
+
+private:
+    File file_;
+    std::vector<Record> front_;
+    std::vector<Record> back_;
+    size_t size_ = 0;
+    std::future<void> pending_;
+};
+
+// Tournament tree of losers over k sources.
+// Every inner node keeps the loser of the match played in it, the overall
+// winner is kept separately. After the winner advances only the matches on
+// the path from its leaf to the root are replayed: log k comparisons,
+// each against a single stored loser.
+template <typename Source, typename Compare>
+class LoserTree {
+public:
+    LoserTree(std::vector<Source*> sources, Compare& comp)
+        : sources_(std::move(sources)), losers_(sources_.size(), kNone), comp_(comp) {
+        winner_ = Build(1);
+    }
+
+    inline bool IsEmpty() const {
+        return winner_ == kNone || sources_[winner_]->IsEmpty();
+    }
+
+    inline Source& Top() const {
+        return *sources_[winner_];
+    }
+
+    // Advances the winning source and replays its path to the root
+    void Next() {
+        sources_[winner_]->Advance();
+
+        size_t winner = winner_;
+        for (size_t node = (winner + sources_.size()) / 2; node > 0; node /= 2) {
+            if (Beats(losers_[node], winner)) {
+                std::swap(losers_[node], winner);
+            }
+        }
+        winner_ = winner;
+    }
+
+private:
+    static constexpr size_t kNone = static_cast<size_t>(-1);
+
+    // Exhausted sources lose to everyone
+    bool Beats(size_t a, size_t b) const {
+        if (a == kNone || sources_[a]->IsEmpty()) {
+            return false;
+        }
+        if (b == kNone || sources_[b]->IsEmpty()) {
+            return true;
+        }
+        return comp_(sources_[a]->Current(), sources_[b]->Current());
+    }
+
+    // Plays all matches of the subtree, returns its winner.
+    // Leaves are implicit: node k + i is source i
+    size_t Build(size_t node) {
+        if (node >= sources_.size()) {
+            return node - sources_.size();
+        }
+
+        size_t left = Build(2 * node);
+        size_t right = Build(2 * node + 1);
+
+        if (Beats(right, left)) {
+            std::swap(left, right);
+        }
+        losers_[node] = right;
+        return left;
+    }
+
+private:
+    std::vector<Source*> sources_;
+    std::vector<size_t> losers_;
+    size_t winner_;
+    Compare& comp_;
+};
+
+// Rename doesn't work across filesystems, so a temp dir on another disk
+// falls back to copying
+inline void MoveFile(const std::filesystem::path& from, const std::filesystem::path& to) {
+    std::error_code error;
+    std::filesystem::rename(from, to, error);
+    if (error) {
+        std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::remove(from);
+    }
+}
+
+// Temporary file removed by its owner: runs don't outlive an exception
+// in the middle of the sort
+class TempFile {
+public:
+    explicit TempFile(std::filesystem::path path) : path_(std::move(path)) {
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    TempFile(TempFile&& other) noexcept : path_(std::move(other.path_)) {
+        other.path_.clear();
+    }
+
+    TempFile& operator=(TempFile&& other) noexcept {
+        if (this != &other) {
+            Remove();
+            path_ = std::move(other.path_);
+            other.path_.clear();
+        }
+        return *this;
+    }
+
+    ~TempFile() {
+        Remove();
+    }
+
+    inline const std::filesystem::path& Path() const noexcept {
+        return path_;
+    }
+
+    void Remove() noexcept {
+        if (!path_.empty()) {
+            std::error_code error;
+            std::filesystem::remove(path_, error);
+            path_.clear();
+        }
+    }
+
+    // The file becomes `to` and is no longer temporary
+    void MoveTo(const std::filesystem::path& to) {
+        MoveFile(path_, to);
+        path_.clear();
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+inline std::filesystem::path RunPath(const std::filesystem::path& dir, const std::filesystem::path& output,
+                                     size_t pass, size_t index) {
+    return dir / (output.filename().string() + ".run" + std::to_string(pass) + "." + std::to_string(index));
+}
+
+}  // namespace detail::external
+
+// Sorts a file of fixed-width records that doesn't fit into memory.
+//
+// 1) Run formation: the input is read by chunks of `memory_budget` bytes,
+//    every chunk is sorted in memory and written as a sorted run.
+// 2) Merge: up to `fan_in` runs are merged at once through a loser tree.
+//    Every run and the output get two blocks of the budget each, so the disk
+//    is busy with the next block while the merge works on the current one.
+//    If there are more runs than the budget can give blocks for, extra
+//    merge passes are made.
+//
+// Runs are kept in `temp_dir` (directory of the output by default) and removed
+// as soon as they are merged, or when an exception leaves the sort.
+template <typename Record, typename Compare = std::less<>>
+void ExternalSort(const std::filesystem::path& input, const std::filesystem::path& output, size_t memory_budget,
+                  Compare comp = Compare(), std::filesystem::path temp_dir = {}) {
+    static_assert(std::is_trivially_copyable_v<Record>, "Records must be fixed-width and trivially copyable");
+
+    using detail::external::File;
+    using detail::external::LoserTree;
+    using detail::external::RunPath;
+    using detail::external::RunReader;
+    using detail::external::RunWriter;
+    using detail::external::TempFile;
+
+    const size_t min_block = std::max(sizeof(Record), detail::external::kMinBlockBytes);
+    // At least two runs with two blocks each plus the double-buffered output
+    if (memory_budget < 6 * min_block) {
+        throw std::invalid_argument("Memory budget is too small");
+    }
+
+    if (std::filesystem::file_size(input) % sizeof(Record) != 0) {
+        throw std::invalid_argument("Input size isn't a multiple of the record size");
+    }
+
+    if (temp_dir.empty()) {
+        temp_dir = std::filesystem::absolute(output).parent_path();
+    }
+
+    // 1) Run formation
+
+    std::vector<TempFile> runs;
+    {
+        File in(input, O_RDONLY);
+        std::vector<Record> chunk(memory_budget / sizeof(Record));
+
+        while (true) {
+            size_t count = in.Read(chunk.data(), chunk.size() * sizeof(Record)) / sizeof(Record);
+            if (count == 0 && !runs.empty()) {
+                break;
+            }
+
+            std::sort(chunk.begin(), chunk.begin() + count, comp);
+
+            runs.emplace_back(RunPath(temp_dir, output, 0, runs.size()));
+            File run(runs.back().Path(), O_WRONLY | O_CREAT | O_TRUNC);
+            run.Write(chunk.data(), count * sizeof(Record));
+
+            if (count < chunk.size()) {
+                break;
+            }
+        }
+    }
+
+    if (runs.size() == 1) {
+        runs.front().MoveTo(output);
+        return;
+    }
+
+    // 2) Merge passes
+
+    const size_t max_fan_in = memory_budget / min_block / 2 - 1;
+
+    for (size_t pass = 1; runs.size() > 1; ++pass) {
+        size_t fan_in = std::min(runs.size(), max_fan_in);
+        size_t block_records = memory_budget / (2 * (fan_in + 1)) / sizeof(Record);
+
+        std::vector<TempFile> merged;
+
+        for (size_t first = 0; first < runs.size(); first += fan_in) {
+            size_t last = std::min(runs.size(), first + fan_in);
+            bool is_final = (runs.size() <= fan_in);
+
+            // A lone last run goes to the next pass as is: names of
+            // the next pass have another number
+            if (last - first == 1) {
+                merged.push_back(std::move(runs[first]));
+                continue;
+            }
+
+            // The final merge writes the output, which isn't temporary
+            TempFile target(is_final ? std::filesystem::path() : RunPath(temp_dir, output, pass, merged.size()));
+            {
+                std::vector<std::unique_ptr<RunReader<Record>>> readers;
+                std::vector<RunReader<Record>*> sources;
+                for (size_t i = first; i < last; ++i) {
+                    readers.push_back(std::make_unique<RunReader<Record>>(runs[i].Path(), block_records));
+                    sources.push_back(readers.back().get());
+                }
+
+                RunWriter<Record> writer(is_final ? output : target.Path(), block_records);
+                LoserTree<RunReader<Record>, Compare> tree(std::move(sources), comp);
+
+                while (!tree.IsEmpty()) {
+                    writer.Push(tree.Top().Current());
+                    tree.Next();
+                }
+                writer.Finish();
+            }
+
+            for (size_t i = first; i < last; ++i) {
+                runs[i].Remove();
+            }
+            merged.push_back(std::move(target));
+        }
+
+        runs = std::move(merged);
+    }
+}
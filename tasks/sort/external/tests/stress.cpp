@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../external_sort.hpp"
+
+// 64-byte record with 8-byte key, typical for fixed-width log records
+struct Record {
+  uint64_t key;
+  char payload[56];
+};
+
+struct RecordComparator {
+  bool operator()(const Record& a, const Record& b) const {
+    return a.key < b.key;
+  }
+};
+
+std::filesystem::path BenchDir() {
+  auto dir = std::filesystem::temp_directory_path() / fmt::format("external_sort_bench_{}", ::getpid());
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+// Generates the input file by blocks, so that it may exceed the memory
+void ConstructRandomFile(const std::filesystem::path& path, size_t bytes) {
+  std::random_device rd;
+  std::mt19937_64 mt(rd());
+  std::ofstream out(path, std::ios::binary);
+  std::vector<Record> block(1 << 14);
+  for (size_t done = 0; done < bytes;) {
+    size_t count = std::min(block.size(), (bytes - done) / sizeof(Record));
+    for (size_t i = 0; i < count; ++i) {
+      block[i].key = mt();
+    }
+    out.write(reinterpret_cast<const char*>(block.data()), count * sizeof(Record));
+    done += count * sizeof(Record);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Args: input size in MiB, memory budget in MiB
+void BM_ExternalSort(benchmark::State& state) {
+  auto dir = BenchDir();
+  auto input = dir / "input.bin";
+  auto output = dir / "output.bin";
+  size_t bytes = static_cast<size_t>(state.range(0)) << 20;
+  size_t budget = static_cast<size_t>(state.range(1)) << 20;
+
+  ConstructRandomFile(input, bytes);
+  for (auto _ : state) {
+    ExternalSort<Record>(input, output, budget, RecordComparator());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+  std::filesystem::remove_all(dir);
+}
+
+// In-memory baseline: read, std::sort, write
+void BM_InMemorySort(benchmark::State& state) {
+  auto dir = BenchDir();
+  auto input = dir / "input.bin";
+  auto output = dir / "output.bin";
+  size_t bytes = static_cast<size_t>(state.range(0)) << 20;
+
+  ConstructRandomFile(input, bytes);
+  std::vector<Record> records(bytes / sizeof(Record));
+  for (auto _ : state) {
+    std::ifstream in(input, std::ios::binary);
+    in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(Record));
+    std::sort(records.begin(), records.end(), RecordComparator());
+    std::ofstream out(output, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+  std::filesystem::remove_all(dir);
+}
+
+
+BENCHMARK(BM_ExternalSort)->ArgsProduct({{64, 256, 1024}, {4, 16, 64}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InMemorySort)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
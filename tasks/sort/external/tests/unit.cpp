@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../external_sort.hpp"
+
+struct Record {
+  uint64_t key;
+  char payload[24];
+};
+
+struct RecordComparator {
+  bool operator()(const Record& a, const Record& b) const {
+    return a.key < b.key;
+  }
+};
+
+class ExternalSortTest: public testing::Test {
+  protected:
+    void SetUp() override {
+      dir = std::filesystem::temp_directory_path() /
+            fmt::format("external_sort_test_{}", ::getpid());
+      std::filesystem::create_directories(dir);
+      input = dir / "input.bin";
+      output = dir / "output.bin";
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(dir);
+    }
+
+    template <typename T>
+    void WriteFile(const std::vector<T>& values) {
+      std::ofstream out(input, std::ios::binary);
+      out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    std::vector<T> ReadOutput() {
+      std::vector<T> values(std::filesystem::file_size(output) / sizeof(T));
+      std::ifstream in(output, std::ios::binary);
+      in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+      return values;
+    }
+
+    // Only input and output must stay in the directory
+    void ExpectNoRunsLeft() {
+      size_t files = std::distance(std::filesystem::directory_iterator(dir),
+                                   std::filesystem::directory_iterator());
+      ASSERT_EQ(files, 2) << "Temporary runs are not removed";
+    }
+
+  std::filesystem::path dir;
+  std::filesystem::path input;
+  std::filesystem::path output;
+};
+
+std::vector<uint64_t> RandomKeys(size_t sz) {
+  std::mt19937_64 mt(42);
+  std::vector<uint64_t> res(sz);
+  for (auto& val : res) {
+    val = mt();
+  }
+  return res;
+}
+
+
+TEST_F(ExternalSortTest, EmptyFile) {
+  WriteFile(std::vector<uint64_t>{});
+  ExternalSort<uint64_t>(input, output, 1 << 16);
+  ASSERT_TRUE(ReadOutput<uint64_t>().empty());
+  ExpectNoRunsLeft();
+}
+
+TEST_F(ExternalSortTest, FitsIntoMemory) {
+  auto values = RandomKeys(1000);
+  WriteFile(values);
+  ExternalSort<uint64_t>(input, output, 1 << 20);
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(ReadOutput<uint64_t>(), values);
+  ExpectNoRunsLeft();
+}
+
+TEST_F(ExternalSortTest, SingleMergePass) {
+  // 64 KiB budget: 1 MiB of keys makes 16 runs, fan-in is 7
+  auto values = RandomKeys(1 << 17);
+  WriteFile(values);
+  ExternalSort<uint64_t>(input, output, 1 << 16);
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(ReadOutput<uint64_t>(), values);
+  ExpectNoRunsLeft();
+}
+
+TEST_F(ExternalSortTest, SeveralMergePasses) {
+  // 24 KiB budget: fan-in is 2, so every pass halves the number of runs
+  auto values = RandomKeys(50000);
+  WriteFile(values);
+  ExternalSort<uint64_t>(input, output, 24 * 1024);
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(ReadOutput<uint64_t>(), values);
+  ExpectNoRunsLeft();
+}
+
+TEST_F(ExternalSortTest, RecordsWithPayloadAndComparator) {
+  std::mt19937 mt(42);
+  std::vector<Record> values(20000);
+  for (auto& record : values) {
+    record.key = mt() % 1000;
+    std::memset(record.payload, 0, sizeof(record.payload));
+    std::snprintf(record.payload, sizeof(record.payload), "%llu",
+                  static_cast<unsigned long long>(record.key));
+  }
+  WriteFile(values);
+  ExternalSort<Record>(input, output, 1 << 16, RecordComparator());
+
+  auto sorted = ReadOutput<Record>();
+  ASSERT_EQ(sorted.size(), values.size());
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (i > 0) {
+      ASSERT_LE(sorted[i - 1].key, sorted[i].key) << fmt::format("Doesn't increase on {} index", i);
+    }
+    ASSERT_EQ(std::to_string(sorted[i].key), sorted[i].payload) << "Record is torn";
+  }
+  ExpectNoRunsLeft();
+}
+
+TEST_F(ExternalSortTest, DescendingOrder) {
+  auto values = RandomKeys(30000);
+  WriteFile(values);
+  ExternalSort<uint64_t>(input, output, 1 << 15, std::greater<>());
+  std::sort(values.begin(), values.end(), std::greater<>());
+  ASSERT_EQ(ReadOutput<uint64_t>(), values);
+}
+
+TEST_F(ExternalSortTest, SeparateTempDir) {
+  auto values = RandomKeys(20000);
+  WriteFile(values);
+  auto temp_dir = dir / "runs";
+  std::filesystem::create_directories(temp_dir);
+  ExternalSort<uint64_t>(input, output, 1 << 15, std::less<>(), temp_dir);
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(ReadOutput<uint64_t>(), values);
+  ASSERT_TRUE(std::filesystem::is_empty(temp_dir));
+}
+
+// Throws after `limit` comparisons
+struct FailingComparator {
+  bool operator()(uint64_t a, uint64_t b) const {
+    if (++*count > limit) {
+      throw std::runtime_error("Comparator failed");
+    }
+    return a < b;
+  }
+
+  size_t* count;
+  size_t limit;
+};
+
+TEST_F(ExternalSortTest, RunsRemovedOnException) {
+  WriteFile(RandomKeys(20000));
+  auto temp_dir = dir / "runs";
+  std::filesystem::create_directories(temp_dir);
+
+  size_t total = 0;
+  ExternalSort<uint64_t>(input, output, 1 << 15, FailingComparator{&total, SIZE_MAX}, temp_dir);
+
+  // While runs are formed, in the middle pass and in the final merge
+  for (size_t limit : {total / 4, total - 10000, total - 10}) {
+    size_t count = 0;
+    EXPECT_THROW({
+      ExternalSort<uint64_t>(input, output, 1 << 15, FailingComparator{&count, limit}, temp_dir);
+    }, std::runtime_error);
+    ASSERT_TRUE(std::filesystem::is_empty(temp_dir)) << "Limit " << limit;
+  }
+}
+
+TEST_F(ExternalSortTest, TooSmallBudget) {
+  WriteFile(RandomKeys(10));
+  EXPECT_THROW({
+    ExternalSort<uint64_t>(input, output, 1024);
+  }, std::invalid_argument);
+}
+
+TEST_F(ExternalSortTest, TornInput) {
+  WriteFile(std::vector<char>(13));
+  EXPECT_THROW({
+    ExternalSort<uint64_t>(input, output, 1 << 16);
+  }, std::invalid_argument);
+}
+
+TEST_F(ExternalSortTest, MissingInput) {
+  EXPECT_ANY_THROW({
+    ExternalSort<uint64_t>(dir / "missing.bin", output, 1 << 16);
+  });
+}
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
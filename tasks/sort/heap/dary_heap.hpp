@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Array-backed D-ary heap.
+// Top() is the minimal element with respect to Compare (min-heap for std::less),
+// which is the natural order for schedulers: the earliest deadline goes first.
+// D is the fan-out: D = 4 or 8 packs all children of a node of small T into
+// one cache line and halves / thirds the height of the binary heap.
+template <typename T, size_t D = 4, typename Compare = std::less<T>>
+class DaryHeap {
+    static_assert(D >= 2, "Heap arity must be at least 2");
+
+public:
+    // Stable reference to a pushed element: stays valid while the element is
+    // in the heap, no matter how many times it is moved inside the array.
+    // Ids are reused after Pop, so a handle also remembers the generation
+    // of its id: a handle of a popped element is rejected, not mistaken
+    // for the element that got the id later.
+    class Handle {
+        friend class DaryHeap;
+
+    public:
+        Handle() : id_(kInvalid), generation_(0) {
+        }
+
+        inline bool operator==(const Handle& other) const {
+            return id_ == other.id_ && generation_ == other.generation_;
+        }
+
+        inline bool operator!=(const Handle& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        Handle(size_t id, size_t generation) : id_(id), generation_(generation) {
+        }
+
+    private:
+        static constexpr size_t kInvalid = static_cast<size_t>(-1);
+        size_t id_;
+        size_t generation_;
+    };
+
+    DaryHeap() = default;
+
+    explicit DaryHeap(const Compare& comp) : comp_(comp) {
+    }
+
+    template <typename InputIt>
+    DaryHeap(InputIt first, InputIt last, const Compare& comp = Compare()) : comp_(comp) {
+        Heapify(first, last);
+    }
+
+    DaryHeap(const std::initializer_list<T>& values) {
+        Heapify(values.begin(), values.end());
+    }
+
+    inline const T& Top() const {
+        if (IsEmpty()) {
+            throw std::runtime_error("Heap is empty");
+        }
+        return slots_.front().value;
+    }
+
+    // Throws std::invalid_argument for a handle of a popped element
+    inline const T& Get(Handle handle) const {
+        return slots_[IndexOf(handle)].value;
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return slots_.empty();
+    }
+
+    inline size_t Size() const noexcept {
+        return slots_.size();
+    }
+
+    Handle Push(const T& value) {
+        return Emplace(value);
+    }
+
+    Handle Push(T&& value) {
+        return Emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    Handle Emplace(Args&&... args) {
+        // A free id is taken off the list only after the slot is in place,
+        // a new one is dropped if T or push_back throws
+        bool is_new_id = free_ids_.empty();
+        if (is_new_id) {
+            entries_.push_back(Entry{0, 0});
+        }
+        size_t id = is_new_id ? entries_.size() - 1 : free_ids_.back();
+        try {
+            slots_.push_back(Slot{T(std::forward<Args>(args)...), id});
+        } catch (...) {
+            if (is_new_id) {
+                entries_.pop_back();
+            }
+            throw;
+        }
+        if (!is_new_id) {
+            free_ids_.pop_back();
+        }
+        entries_[id].index = slots_.size() - 1;
+        SiftUp(slots_.size() - 1);
+        return Handle(id, entries_[id].generation);
+    }
+
+    void Pop() {
+        if (IsEmpty()) {
+            throw std::runtime_error("Heap is empty");
+        }
+
+        ReleaseId(slots_.front().id);
+
+        if (slots_.size() > 1) {
+            Place(0, std::move(slots_.back()));
+            slots_.pop_back();
+            SiftDown(0);
+        } else {
+            slots_.pop_back();
+        }
+    }
+
+    // Replaces the value of the element by a not greater one
+    void DecreaseKey(Handle handle, const T& value) {
+        size_t index = IndexOf(handle);
+
+        if (comp_(slots_[index].value, value)) {
+            throw std::invalid_argument("DecreaseKey can't increase the key");
+        }
+
+        slots_[index].value = value;
+        SiftUp(index);
+    }
+
+    // Builds the heap from the range in O(n): sifts down every inner node,
+    // starting from the last one. Previous content is dropped.
+    template <typename InputIt>
+    void Heapify(InputIt first, InputIt last) {
+        Clear();
+
+        for (; first != last; ++first) {
+            slots_.push_back(Slot{*first, slots_.size()});
+        }
+
+        // Ids 0..n-1 are taken in order, generations stay as Clear left them
+        if (entries_.size() < slots_.size()) {
+            entries_.resize(slots_.size(), Entry{0, 0});
+        }
+        free_ids_.clear();
+        for (size_t id = entries_.size(); id-- > slots_.size();) {
+            free_ids_.push_back(id);
+        }
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            entries_[i].index = i;
+        }
+
+        if (slots_.size() < 2) {
+            return;
+        }
+
+        for (size_t i = Parent(slots_.size() - 1) + 1; i-- > 0;) {
+            SiftDown(i);
+        }
+    }
+
+    // Handles of the dropped elements become stale: ids are kept with
+    // their generations bumped
+    void Clear() {
+        for (const Slot& slot : slots_) {
+            ReleaseId(slot.id);
+        }
+        slots_.clear();
+    }
+
+    void Swap(DaryHeap& other) {
+        std::swap(comp_, other.comp_);
+        std::swap(slots_, other.slots_);
+        std::swap(entries_, other.entries_);
+        std::swap(free_ids_, other.free_ids_);
+    }
+
+private:
+    struct Slot {
+        T value;
+        size_t id;
+    };
+
+    struct Entry {
+        // Position of the element in slots_
+        size_t index;
+        // Bumped every time the id is released
+        size_t generation;
+    };
+
+    static inline size_t Parent(size_t index) noexcept {
+        return (index - 1) / D;
+    }
+
+    static inline size_t FirstChild(size_t index) noexcept {
+        return index * D + 1;
+    }
+
+    void ReleaseId(size_t id) {
+        ++entries_[id].generation;
+        free_ids_.push_back(id);
+    }
+
+    size_t IndexOf(Handle handle) const {
+        if (handle.id_ >= entries_.size() || entries_[handle.id_].generation != handle.generation_) {
+            throw std::invalid_argument("Handle of an element that is not in the heap");
+        }
+        return entries_[handle.id_].index;
+    }
+
+    inline void Place(size_t index, Slot&& slot) {
+        entries_[slot.id].index = index;
+        slots_[index] = std::move(slot);
+    }
+
+    // Both sifts move a hole instead of swapping: one move per level
+    void SiftUp(size_t index) {
+        Slot slot = std::move(slots_[index]);
+
+        while (index > 0) {
+            size_t parent = Parent(index);
+            if (!comp_(slot.value, slots_[parent].value)) {
+                break;
+            }
+            Place(index, std::move(slots_[parent]));
+            index = parent;
+        }
+
+        Place(index, std::move(slot));
+    }
+
+    void SiftDown(size_t index) {
+        size_t size = slots_.size();
+        Slot slot = std::move(slots_[index]);
+
+        while (true) {
+            size_t first = FirstChild(index);
+            if (first >= size) {
+                break;
+            }
+
+            size_t last = std::min(first + D, size);
+            size_t best = first;
+            for (size_t child = first + 1; child < last; ++child) {
+                if (comp_(slots_[child].value, slots_[best].value)) {
+                    best = child;
+                }
+            }
+
+            if (!comp_(slots_[best].value, slot.value)) {
+                break;
+            }
+            Place(index, std::move(slots_[best]));
+            index = best;
+        }
+
+        Place(index, std::move(slot));
+    }
+
+private:
+    Compare comp_;
+    std::vector<Slot> slots_;
+    // Position and generation of the element by its handle id
+    std::vector<Entry> entries_;
+    std::vector<size_t> free_ids_;
+};
+
+namespace std {
+// Global swap overloading
+template <typename T, size_t D, typename Compare>
+// NOLINTNEXTLINE
+void swap(DaryHeap<T, D, Compare>& a, DaryHeap<T, D, Compare>& b) {
+    a.Swap(b);
+}
+}  // namespace std
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace detail::heap_sort {
+
+template <typename RandomIt>
+inline void Prefetch([[maybe_unused]] RandomIt it) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(std::addressof(*it));
+#endif
+}
+
+// Floyd's bottom-up sift-down of a hole at index `hole`.
+// The hole first descends to a leaf along the path of larger children
+// (one comparison per level instead of two), then `value` climbs back up.
+// Extracted elements come from the bottom of the heap and usually belong
+// near the leaves, so the climb is short and the whole sift takes ~log n
+// comparisons instead of ~2 log n.
+template <typename RandomIt, typename T, typename Compare>
+void SiftBottomUp(RandomIt first, size_t hole, size_t size, T&& value, Compare& comp) {
+    const size_t top = hole;
+    size_t child = 2 * hole + 1;
+
+    while (child + 1 < size) {
+        // Grandchildren of the current node are the next level we descend to:
+        // loading them now hides the memory latency of the next iteration
+        if (4 * hole + 3 < size) {
+            Prefetch(first + (4 * hole + 3));
+        }
+
+        if (comp(first[child], first[child + 1])) {
+            ++child;
+        }
+        first[hole] = std::move(first[child]);
+        hole = child;
+        child = 2 * hole + 1;
+    }
+
+    if (child < size) {
+        first[hole] = std::move(first[child]);
+        hole = child;
+    }
+
+    while (hole > top) {
+        size_t parent = (hole - 1) / 2;
+        if (!comp(first[parent], value)) {
+            break;
+        }
+        first[hole] = std::move(first[parent]);
+        hole = parent;
+    }
+
+    first[hole] = std::forward<T>(value);
+}
+
+}  // namespace detail::heap_sort
+
+// In-place heapsort: worst-case O(n log n) time and O(1) additional memory.
+// Not stable. Builds a max-heap by Floyd's method, then repeatedly moves
+// the maximum to the end of the range.
+template <typename RandomIt, typename Compare = std::less<>>
+void HeapSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    size_t size = std::distance(first, last);
+
+    if (size < 2) {
+        return;
+    }
+
+    for (size_t i = size / 2; i-- > 0;) {
+        auto value = std::move(first[i]);
+        detail::heap_sort::SiftBottomUp(first, i, size, std::move(value), comp);
+    }
+
+    for (size_t end = size - 1; end > 0; --end) {
+        auto value = std::move(first[end]);
+        first[end] = std::move(first[0]);
+        detail::heap_sort::SiftBottomUp(first, 0, end, std::move(value), comp);
+    }
+}
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "pool_allocator.hpp"
+
+// Node-based mergeable heap.
+// Same order as DaryHeap: Top() is the minimal element with respect to Compare.
+//
+// Push, Meld and Top are O(1), Pop is O(log n) amortized, DecreaseKey is
+// O(1) in practice (o(log n) amortized in theory).
+// Nodes come from a pool that moves to the receiving heap on Meld, so melding
+// never copies elements.
+template <typename T, typename Compare = std::less<T>>
+class PairingHeap {
+    class Node;
+
+public:
+    // Stable reference to a pushed element, valid until the element is popped.
+    // Survives Meld: the element keeps its node in the receiving heap.
+    class Handle {
+        friend class PairingHeap;
+
+    public:
+        Handle() : node_(nullptr) {
+        }
+
+        inline bool operator==(const Handle& other) const {
+            return node_ == other.node_;
+        }
+
+        inline bool operator!=(const Handle& other) const {
+            return node_ != other.node_;
+        }
+
+    private:
+        explicit Handle(Node* node) : node_(node) {
+        }
+
+    private:
+        Node* node_;
+    };
+
+    PairingHeap() = default;
+
+    explicit PairingHeap(const Compare& comp) : comp_(comp) {
+    }
+
+    PairingHeap(const std::initializer_list<T>& values) {
+        for (const auto& value : values) {
+            Push(value);
+        }
+    }
+
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap& operator=(const PairingHeap&) = delete;
+
+    PairingHeap(PairingHeap&& other) noexcept {
+        Swap(other);
+    }
+
+    PairingHeap& operator=(PairingHeap&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    inline const T& Top() const {
+        if (IsEmpty()) {
+            throw std::runtime_error("Heap is empty");
+        }
+        return root_->value_;
+    }
+
+    inline const T& Get(Handle handle) const {
+        return handle.node_->value_;
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return root_ == nullptr;
+    }
+
+    inline size_t Size() const noexcept {
+        return sz_;
+    }
+
+    Handle Push(const T& value) {
+        return Emplace(value);
+    }
+
+    Handle Push(T&& value) {
+        return Emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    Handle Emplace(Args&&... args) {
+        Node* node = pool_.New(std::forward<Args>(args)...);
+        root_ = (root_ == nullptr) ? node : Link(root_, node);
+        ++sz_;
+        return Handle(node);
+    }
+
+    void Pop() {
+        if (IsEmpty()) {
+            throw std::runtime_error("Heap is empty");
+        }
+
+        Node* children = root_->child_;
+        pool_.Delete(root_);
+        --sz_;
+
+        root_ = MergePairs(children);
+    }
+
+    // Replaces the value of the element by a not greater one.
+    // The node is cut from its parent together with its subtree
+    // and linked with the root.
+    void DecreaseKey(Handle handle, const T& value) {
+        Node* node = handle.node_;
+
+        if (comp_(node->value_, value)) {
+            throw std::invalid_argument("DecreaseKey can't increase the key");
+        }
+
+        node->value_ = value;
+        if (node == root_) {
+            return;
+        }
+
+        Cut(node);
+        root_ = Link(root_, node);
+    }
+
+    // Moves all elements of other into this heap in O(1), other becomes empty.
+    // Handles to elements of other stay valid and now refer to this heap.
+    void Meld(PairingHeap& other) {
+        if (this == &other || other.IsEmpty()) {
+            return;
+        }
+
+        pool_.Splice(other.pool_);
+        root_ = IsEmpty() ? other.root_ : Link(root_, other.root_);
+        sz_ += other.sz_;
+
+        other.root_ = nullptr;
+        other.sz_ = 0;
+    }
+
+    void Meld(PairingHeap&& other) {
+        Meld(other);
+    }
+
+    void Clear() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            Destroy(root_);
+        }
+        pool_.Release();
+        root_ = nullptr;
+        sz_ = 0;
+    }
+
+    void Swap(PairingHeap& other) noexcept {
+        std::swap(comp_, other.comp_);
+        std::swap(root_, other.root_);
+        std::swap(sz_, other.sz_);
+        pool_.Swap(other.pool_);
+    }
+
+    ~PairingHeap() {
+        Clear();
+    }
+
+private:
+    class Node {
+        friend class PairingHeap;
+
+    public:
+        template <typename... Args>
+        explicit Node(Args&&... args) : value_(std::forward<Args>(args)...) {
+        }
+
+    private:
+        T value_;
+        // Leftmost child
+        Node* child_ = nullptr;
+        // Right sibling
+        Node* next_ = nullptr;
+        // Left sibling, or parent for the leftmost child
+        Node* prev_ = nullptr;
+    };
+
+    // Links two detached roots: the loser becomes the leftmost child of the winner
+    Node* Link(Node* a, Node* b) {
+        if (comp_(b->value_, a->value_)) {
+            std::swap(a, b);
+        }
+
+        b->prev_ = a;
+        b->next_ = a->child_;
+        if (a->child_ != nullptr) {
+            a->child_->prev_ = b;
+        }
+        a->child_ = b;
+        return a;
+    }
+
+    static void Cut(Node* node) {
+        if (node->prev_->child_ == node) {
+            node->prev_->child_ = node->next_;
+        } else {
+            node->prev_->next_ = node->next_;
+        }
+        if (node->next_ != nullptr) {
+            node->next_->prev_ = node->prev_;
+        }
+        node->next_ = nullptr;
+        node->prev_ = nullptr;
+    }
+
+    // Two-pass pairing of a sibling list: link neighbours left to right,
+    // then link the results right to left. Both passes are iterative,
+    // so a long list of children can't overflow the stack.
+    Node* MergePairs(Node* first) {
+        if (first == nullptr) {
+            return nullptr;
+        }
+
+        // First pass, results are collected in reverse order through next_
+        Node* paired = nullptr;
+        while (first != nullptr) {
+            Node* a = first;
+            Node* b = a->next_;
+            first = (b != nullptr) ? b->next_ : nullptr;
+
+            a->next_ = a->prev_ = nullptr;
+            if (b != nullptr) {
+                b->next_ = b->prev_ = nullptr;
+                a = Link(a, b);
+            }
+            a->next_ = paired;
+            paired = a;
+        }
+
+        // Second pass: the reversed list is linked from its head
+        Node* result = paired;
+        Node* rest = paired->next_;
+        result->next_ = nullptr;
+        while (rest != nullptr) {
+            Node* next = rest->next_;
+            rest->next_ = nullptr;
+            result = Link(result, rest);
+            rest = next;
+        }
+
+        result->prev_ = nullptr;
+        return result;
+    }
+
+    // Calls destructors of all elements; memory goes back with the whole pool.
+    // Iterative: child lists are spliced into the sibling chain being walked
+    void Destroy(Node* node) noexcept {
+        while (node != nullptr) {
+            if (node->child_ != nullptr) {
+                Node* last = node->child_;
+                while (last->next_ != nullptr) {
+                    last = last->next_;
+                }
+                last->next_ = node->next_;
+                node->next_ = node->child_;
+                node->child_ = nullptr;
+            }
+            Node* next = node->next_;
+            node->~Node();
+            node = next;
+        }
+    }
+
+private:
+    Compare comp_;
+    Node* root_ = nullptr;
+    size_t sz_ = 0;
+    PoolAllocator<Node> pool_;
+};
+
+namespace std {
+// Global swap overloading
+template <typename T, typename Compare>
+// NOLINTNEXTLINE
+void swap(PairingHeap<T, Compare>& a, PairingHeap<T, Compare>& b) {
+    a.Swap(b);
+}
+}  // namespace std
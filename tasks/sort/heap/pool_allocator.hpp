@@ -0,0 +1,217 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Fixed-size object pool: objects are carved out of slabs of at least
+// SlabSize cells, freed cells go to an intrusive free list of their slab
+// and are reused first. Allocation and deallocation are a couple of pointer
+// moves, nodes allocated together lie together in memory.
+//
+// Slabs are aligned to their size, so a cell finds its slab by masking its
+// address. Every slab counts its live cells: a slab that becomes empty is
+// freed unless it is the last one with spare cells, and memory of a pool
+// stays proportional to the number of live objects.
+//
+// Release() frees whole slabs without calling destructors: the owner must
+// destroy live objects itself (or have trivially destructible ones).
+template <typename T, size_t SlabSize = 256>
+class PoolAllocator {
+    static_assert(SlabSize > 0, "Slab must hold at least one object");
+
+public:
+    PoolAllocator() = default;
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    PoolAllocator(PoolAllocator&& other) noexcept {
+        Swap(other);
+    }
+
+    PoolAllocator& operator=(PoolAllocator&& other) noexcept {
+        if (this != &other) {
+            Release();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    template <typename... Args>
+    T* New(Args&&... args) {
+        Cell* cell = AcquireCell();
+        try {
+            return new (cell->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            ReturnCell(cell);
+            throw;
+        }
+    }
+
+    void Delete(T* object) noexcept {
+        object->~T();
+        ReturnCell(reinterpret_cast<Cell*>(object));
+    }
+
+    // Takes over all slabs of other in O(1): objects allocated by other may
+    // then be deleted through this pool, and the spare cells of its slabs
+    // are used by this pool
+    void Splice(PoolAllocator& other) noexcept {
+        available_.Append(other.available_);
+        full_.Append(other.full_);
+        slabs_ += std::exchange(other.slabs_, 0);
+    }
+
+    // Frees all slabs in O(number of slabs)
+    void Release() noexcept {
+        for (SlabList* list : {&available_, &full_}) {
+            while (list->head != nullptr) {
+                Slab* slab = list->head;
+                list->Remove(slab);
+                DeleteSlab(slab);
+            }
+        }
+        slabs_ = 0;
+    }
+
+    void Swap(PoolAllocator& other) noexcept {
+        std::swap(available_, other.available_);
+        std::swap(full_, other.full_);
+        std::swap(slabs_, other.slabs_);
+    }
+
+    inline size_t SlabCount() const noexcept {
+        return slabs_;
+    }
+
+    ~PoolAllocator() {
+        Release();
+    }
+
+private:
+    union Cell {
+        Cell* next;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    struct Slab;
+
+    struct SlabHeader {
+        Slab* prev;
+        Slab* next;
+        // Freed cells of this slab
+        Cell* free;
+        // Cells [0, bumped) were handed out at least once
+        size_t bumped;
+        size_t live;
+    };
+
+    // The slab fills a power of two bytes: cells take the rest after the header
+    static constexpr size_t kHeaderBytes = (sizeof(SlabHeader) + alignof(Cell) - 1) / alignof(Cell) * alignof(Cell);
+    static constexpr size_t kSlabBytes = std::bit_ceil(kHeaderBytes + SlabSize * sizeof(Cell));
+    static constexpr size_t kCells = (kSlabBytes - kHeaderBytes) / sizeof(Cell);
+
+    struct Slab : SlabHeader {
+        Cell cells[kCells];
+    };
+
+    static_assert(sizeof(Slab) <= kSlabBytes && alignof(Slab) <= kSlabBytes);
+
+    // Intrusive doubly linked list of slabs
+    struct SlabList {
+        Slab* head = nullptr;
+        Slab* tail = nullptr;
+
+        void PushFront(Slab* slab) noexcept {
+            slab->prev = nullptr;
+            slab->next = head;
+            (head != nullptr ? head->prev : tail) = slab;
+            head = slab;
+        }
+
+        void Remove(Slab* slab) noexcept {
+            (slab->prev != nullptr ? slab->prev->next : head) = slab->next;
+            (slab->next != nullptr ? slab->next->prev : tail) = slab->prev;
+        }
+
+        void Append(SlabList& other) noexcept {
+            if (other.head == nullptr) {
+                return;
+            }
+            other.head->prev = tail;
+            (tail != nullptr ? tail->next : head) = other.head;
+            tail = other.tail;
+            other.head = other.tail = nullptr;
+        }
+    };
+
+    static inline Slab* SlabOf(Cell* cell) noexcept {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(cell) & ~(kSlabBytes - 1));
+    }
+
+    static inline bool IsFull(const Slab* slab) noexcept {
+        return slab->free == nullptr && slab->bumped == kCells;
+    }
+
+    Slab* NewSlab() {
+        Slab* slab = new (::operator new(kSlabBytes, std::align_val_t{kSlabBytes})) Slab;
+        slab->free = nullptr;
+        slab->bumped = 0;
+        slab->live = 0;
+        ++slabs_;
+        return slab;
+    }
+
+    void DeleteSlab(Slab* slab) noexcept {
+        ::operator delete(slab, std::align_val_t{kSlabBytes});
+        --slabs_;
+    }
+
+    Cell* AcquireCell() {
+        if (available_.head == nullptr) {
+            available_.PushFront(NewSlab());
+        }
+
+        Slab* slab = available_.head;
+        Cell* cell = slab->free;
+        if (cell != nullptr) {
+            slab->free = cell->next;
+        } else {
+            cell = slab->cells + slab->bumped++;
+        }
+        ++slab->live;
+
+        if (IsFull(slab)) {
+            available_.Remove(slab);
+            full_.PushFront(slab);
+        }
+        return cell;
+    }
+
+    void ReturnCell(Cell* cell) noexcept {
+        Slab* slab = SlabOf(cell);
+        if (IsFull(slab)) {
+            full_.Remove(slab);
+            available_.PushFront(slab);
+        }
+
+        cell->next = slab->free;
+        slab->free = cell;
+        --slab->live;
+
+        // The last slab with spare cells stays: Push after Pop doesn't allocate
+        if (slab->live == 0 && (available_.head != slab || available_.tail != slab)) {
+            available_.Remove(slab);
+            DeleteSlab(slab);
+        }
+    }
+
+private:
+    // Slabs with spare cells, the first one serves allocations
+    SlabList available_;
+    SlabList full_;
+    size_t slabs_ = 0;
+};
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../dary_heap.hpp"
+#include "../heap_sort.hpp"
+#include "../pairing_heap.hpp"
+
+std::vector<int> ConstructRandomVector(int sz) {
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
+  std::vector<int> res(sz);
+  for (auto& val : res) {
+    val = dist(mt);
+  }
+  return res;
+}
+
+// Key that counts its own moves: heapsort moves elements instead of swapping,
+// one std::swap is three moves
+struct CountedKey {
+  int value;
+
+  static inline size_t moves = 0;
+
+  CountedKey() = default;
+  explicit CountedKey(int val) : value(val) {}
+  CountedKey(const CountedKey&) = default;
+  CountedKey(CountedKey&& other) noexcept : value(other.value) { ++moves; }
+  CountedKey& operator=(const CountedKey&) = default;
+  CountedKey& operator=(CountedKey&& other) noexcept {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+};
+
+std::vector<CountedKey> ConstructCountedVector(int sz) {
+  auto values = ConstructRandomVector(sz);
+  return std::vector<CountedKey>(values.begin(), values.end());
+}
+
+// Runs sort on a fresh copy of random keys and reports comparisons
+// and swaps (moves / 3) per element as custom counters
+template <typename Sort>
+void RunCountedSort(benchmark::State& state, Sort sort) {
+  auto values = ConstructCountedVector(state.range(0));
+  auto copy = values;
+  size_t comparisons = 0;
+  size_t moves = 0;
+  auto comp = [&comparisons](const CountedKey& a, const CountedKey& b) {
+    ++comparisons;
+    return a.value < b.value;
+  };
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    size_t moves_before = CountedKey::moves;
+    state.ResumeTiming();
+    sort(copy.begin(), copy.end(), comp);
+    moves += CountedKey::moves - moves_before;
+  }
+  state.counters["comparisons"] = benchmark::Counter(
+      static_cast<double>(comparisons), benchmark::Counter::kAvgIterations);
+  state.counters["swaps"] = benchmark::Counter(
+      static_cast<double>(moves) / 3, benchmark::Counter::kAvgIterations);
+  state.SetComplexityN(state.range(0));
+}
+
+using StdMinHeap = std::priority_queue<int, std::vector<int>, std::greater<>>;
+
+////////////////////////////////////////////////////////////////////////////////
+template <size_t D>
+void BM_DaryHeapPushPop(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  for (auto _ : state) {
+    DaryHeap<int, D> heap;
+    for (int value : values) {
+      heap.Push(value);
+    }
+    while (!heap.IsEmpty()) {
+      benchmark::DoNotOptimize(heap.Top());
+      heap.Pop();
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdPriorityQueuePushPop(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  for (auto _ : state) {
+    StdMinHeap heap;
+    for (int value : values) {
+      heap.push(value);
+    }
+    while (!heap.empty()) {
+      benchmark::DoNotOptimize(heap.top());
+      heap.pop();
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+template <size_t D>
+void BM_DaryHeapHeapify(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  DaryHeap<int, D> heap;
+  for (auto _ : state) {
+    heap.Heapify(values.begin(), values.end());
+    benchmark::DoNotOptimize(heap.Top());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdPriorityQueueHeapify(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  for (auto _ : state) {
+    StdMinHeap heap(values.begin(), values.end());
+    benchmark::DoNotOptimize(heap.top());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Every element gets its key lowered once before being popped
+template <size_t D>
+void BM_DaryHeapDecreaseKey(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  std::vector<typename DaryHeap<int, D>::Handle> handles(values.size());
+  for (auto _ : state) {
+    DaryHeap<int, D> heap;
+    for (size_t i = 0; i < values.size(); ++i) {
+      handles[i] = heap.Push(values[i]);
+    }
+    for (size_t i = 0; i < values.size(); ++i) {
+      int value = heap.Get(handles[i]);
+      heap.DecreaseKey(handles[i], value / 2 - (INT_MAX / 2));
+    }
+    while (!heap.IsEmpty()) {
+      heap.Pop();
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// std::priority_queue has no decrease-key: the usual workaround is
+// to push a duplicate with the new key and skip stale entries on pop
+void BM_StdPriorityQueueLazyDecreaseKey(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  using Entry = std::pair<int, size_t>;
+  std::vector<int> keys(values.size());
+  for (auto _ : state) {
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+    for (size_t i = 0; i < values.size(); ++i) {
+      keys[i] = values[i];
+      heap.push({values[i], i});
+    }
+    for (size_t i = 0; i < values.size(); ++i) {
+      keys[i] = keys[i] / 2 - (INT_MAX / 2);
+      heap.push({keys[i], i});
+    }
+    while (!heap.empty()) {
+      auto [key, idx] = heap.top();
+      heap.pop();
+      benchmark::DoNotOptimize(key == keys[idx]);
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+
+void BM_HeapSort(benchmark::State& state) {
+  RunCountedSort(state, [](auto first, auto last, auto comp) {
+    HeapSort(first, last, comp);
+  });
+}
+
+void BM_StdSortHeap(benchmark::State& state) {
+  RunCountedSort(state, [](auto first, auto last, auto comp) {
+    std::make_heap(first, last, comp);
+    std::sort_heap(first, last, comp);
+  });
+}
+
+void BM_StdSort(benchmark::State& state) {
+  RunCountedSort(state, [](auto first, auto last, auto comp) {
+    std::sort(first, last, comp);
+  });
+}
+
+void BM_StdStableSort(benchmark::State& state) {
+  RunCountedSort(state, [](auto first, auto last, auto comp) {
+    std::stable_sort(first, last, comp);
+  });
+}
+
+// Elements are spread over 16 worker queues, which are melded into one,
+// drained by a quarter and split back round-robin, several rounds in a row
+constexpr size_t kWorkers = 16;
+constexpr int kMeldRounds = 8;
+
+void BM_PairingHeapMeld(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  for (auto _ : state) {
+    std::vector<PairingHeap<int>> workers(kWorkers);
+    for (size_t i = 0; i < values.size(); ++i) {
+      workers[i % kWorkers].Push(values[i]);
+    }
+    for (int round = 0; round < kMeldRounds; ++round) {
+      PairingHeap<int> all;
+      for (auto& worker : workers) {
+        all.Meld(worker);
+      }
+      for (size_t i = 0; i < values.size() / 4; ++i) {
+        workers[i % kWorkers].Push(all.Top());
+        all.Pop();
+      }
+      workers[0].Meld(all);
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+template <size_t D>
+void BM_DaryHeapMeld(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  for (auto _ : state) {
+    std::vector<DaryHeap<int, D>> workers(kWorkers);
+    for (size_t i = 0; i < values.size(); ++i) {
+      workers[i % kWorkers].Push(values[i]);
+    }
+    for (int round = 0; round < kMeldRounds; ++round) {
+      // Array heap has no cheap meld: every element is pushed again
+      DaryHeap<int, D> all;
+      for (auto& worker : workers) {
+        while (!worker.IsEmpty()) {
+          all.Push(worker.Top());
+          worker.Pop();
+        }
+      }
+      for (size_t i = 0; i < values.size() / 4; ++i) {
+        workers[i % kWorkers].Push(all.Top());
+        all.Pop();
+      }
+      workers[0].Swap(all);
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Every element gets its key lowered three times before being popped
+void BM_PairingHeapDecreaseKey(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  std::vector<PairingHeap<int>::Handle> handles(values.size());
+  for (auto _ : state) {
+    PairingHeap<int> heap;
+    for (size_t i = 0; i < values.size(); ++i) {
+      handles[i] = heap.Push(values[i]);
+    }
+    for (int round = 0; round < 3; ++round) {
+      for (size_t i = 0; i < values.size(); ++i) {
+        int value = heap.Get(handles[i]);
+        heap.DecreaseKey(handles[i], value / 2 - (INT_MAX / 2));
+      }
+    }
+    while (!heap.IsEmpty()) {
+      heap.Pop();
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+template <size_t D>
+void BM_DaryHeapDecreaseKeyHeavy(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  std::vector<typename DaryHeap<int, D>::Handle> handles(values.size());
+  for (auto _ : state) {
+    DaryHeap<int, D> heap;
+    for (size_t i = 0; i < values.size(); ++i) {
+      handles[i] = heap.Push(values[i]);
+    }
+    for (int round = 0; round < 3; ++round) {
+      for (size_t i = 0; i < values.size(); ++i) {
+        int value = heap.Get(handles[i]);
+        heap.DecreaseKey(handles[i], value / 2 - (INT_MAX / 2));
+      }
+    }
+    while (!heap.IsEmpty()) {
+      heap.Pop();
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_PairingHeapPushPop(benchmark::State& state) {
+  auto values = ConstructRandomVector(state.range(0));
+  for (auto _ : state) {
+    PairingHeap<int> heap;
+    for (int value : values) {
+      heap.Push(value);
+    }
+    while (!heap.IsEmpty()) {
+      benchmark::DoNotOptimize(heap.Top());
+      heap.Pop();
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+BENCHMARK(BM_DaryHeapPushPop<2>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapPushPop<4>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapPushPop<8>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdPriorityQueuePushPop)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapHeapify<2>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapHeapify<4>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapHeapify<8>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdPriorityQueueHeapify)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapDecreaseKey<2>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapDecreaseKey<4>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapDecreaseKey<8>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdPriorityQueueLazyDecreaseKey)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HeapSort)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdSortHeap)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdSort)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdStableSort)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PairingHeapPushPop)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PairingHeapMeld)->Range(1<<10, 1<<18)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapMeld<4>)->Range(1<<10, 1<<18)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PairingHeapDecreaseKey)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DaryHeapDecreaseKeyHeavy<4>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../dary_heap.hpp"
+#include "../heap_sort.hpp"
+#include "../pairing_heap.hpp"
+
+template <typename Heap>
+std::vector<int> Drain(Heap& heap) {
+  std::vector<int> res;
+  while (!heap.IsEmpty()) {
+    res.push_back(heap.Top());
+    heap.Pop();
+  }
+  return res;
+}
+
+template <typename Heap>
+class DaryHeapTest: public testing::Test {};
+
+using Arities = testing::Types<DaryHeap<int, 2>, DaryHeap<int, 3>, DaryHeap<int, 4>, DaryHeap<int, 8>>;
+TYPED_TEST_SUITE(DaryHeapTest, Arities);
+
+
+TYPED_TEST(DaryHeapTest, DefaultConstructor) {
+  TypeParam heap;
+  ASSERT_TRUE(heap.IsEmpty()) << "Default heap isn't empty!";
+  ASSERT_EQ(heap.Size(), 0);
+}
+
+TYPED_TEST(DaryHeapTest, PushTop) {
+  TypeParam heap;
+  heap.Push(5);
+  ASSERT_EQ(heap.Top(), 5);
+  heap.Push(3);
+  ASSERT_EQ(heap.Top(), 3);
+  heap.Push(7);
+  ASSERT_EQ(heap.Top(), 3);
+  ASSERT_EQ(heap.Size(), 3);
+}
+
+TYPED_TEST(DaryHeapTest, PopEmptyHeap) {
+  TypeParam heap;
+  EXPECT_THROW({
+    heap.Pop();
+  }, std::runtime_error);
+  EXPECT_THROW({
+    heap.Top();
+  }, std::runtime_error);
+}
+
+TYPED_TEST(DaryHeapTest, RandomPushPop) {
+  std::mt19937 mt(42);
+  std::uniform_int_distribution<int> dist(-1000, 1000);
+  TypeParam heap;
+  std::priority_queue<int, std::vector<int>, std::greater<>> expected;
+
+  for (int i = 0; i < 10000; ++i) {
+    if (expected.empty() || dist(mt) > -300) {
+      int value = dist(mt);
+      heap.Push(value);
+      expected.push(value);
+    } else {
+      ASSERT_EQ(heap.Top(), expected.top());
+      heap.Pop();
+      expected.pop();
+    }
+    ASSERT_EQ(heap.Size(), expected.size());
+  }
+}
+
+TYPED_TEST(DaryHeapTest, Heapify) {
+  std::vector<int> values(1000);
+  std::mt19937 mt(42);
+  for (auto& value : values) {
+    value = static_cast<int>(mt() % 100);
+  }
+
+  TypeParam heap;
+  heap.Push(-1);
+  heap.Heapify(values.begin(), values.end());
+  ASSERT_EQ(heap.Size(), values.size()) << "Heapify must drop previous content";
+
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(Drain(heap), values);
+}
+
+TYPED_TEST(DaryHeapTest, DecreaseKey) {
+  TypeParam heap;
+  std::vector<typename TypeParam::Handle> handles;
+  for (int i = 0; i < 100; ++i) {
+    handles.push_back(heap.Push(i + 100));
+  }
+
+  heap.DecreaseKey(handles[50], 1);
+  ASSERT_EQ(heap.Top(), 1);
+  ASSERT_EQ(heap.Get(handles[50]), 1);
+
+  heap.DecreaseKey(handles[99], 0);
+  ASSERT_EQ(heap.Top(), 0);
+  heap.Pop();
+  ASSERT_EQ(heap.Top(), 1);
+
+  // Handles stay valid after elements move inside the array
+  ASSERT_EQ(heap.Get(handles[0]), 100);
+  ASSERT_EQ(heap.Get(handles[98]), 198);
+}
+
+TYPED_TEST(DaryHeapTest, DecreaseKeyIncrease) {
+  TypeParam heap;
+  auto handle = heap.Push(5);
+  EXPECT_THROW({
+    heap.DecreaseKey(handle, 6);
+  }, std::invalid_argument);
+}
+
+// The id of a popped element goes to the next Push: the old handle
+// must not reach the new element
+TYPED_TEST(DaryHeapTest, StaleHandle) {
+  TypeParam heap;
+  auto old_handle = heap.Push(1);
+  heap.Push(10);
+  heap.Pop();
+  auto new_handle = heap.Push(5);
+
+  ASSERT_NE(old_handle, new_handle);
+  ASSERT_THROW(heap.Get(old_handle), std::invalid_argument);
+  ASSERT_THROW(heap.DecreaseKey(old_handle, 0), std::invalid_argument);
+  ASSERT_EQ(heap.Get(new_handle), 5);
+  ASSERT_EQ(Drain(heap), (std::vector<int>{5, 10}));
+
+  // Clear and Heapify drop the elements of all handles too
+  auto handle = heap.Push(3);
+  std::vector<int> values{7, 8};
+  heap.Heapify(values.begin(), values.end());
+  ASSERT_THROW(heap.Get(handle), std::invalid_argument);
+  handle = heap.Push(1);
+  heap.Clear();
+  ASSERT_THROW(heap.DecreaseKey(handle, 0), std::invalid_argument);
+  ASSERT_THROW(heap.Get(typename TypeParam::Handle()), std::invalid_argument);
+}
+
+struct ThrowingValue {
+  explicit ThrowingValue(int value) : value(value) {
+    if (value < 0) {
+      throw std::runtime_error("Negative value");
+    }
+  }
+
+  bool operator<(const ThrowingValue& other) const {
+    return value < other.value;
+  }
+
+  int value;
+};
+
+// A throwing element takes no id: handles and order stay consistent
+TEST(DaryHeapCustomTest, ThrowingEmplace) {
+  DaryHeap<ThrowingValue> heap;
+  ASSERT_THROW(heap.Emplace(-1), std::runtime_error);
+  ASSERT_TRUE(heap.IsEmpty());
+
+  auto first = heap.Emplace(3);
+  auto popped = heap.Emplace(1);
+  heap.Pop();
+  ASSERT_THROW(heap.Emplace(-2), std::runtime_error);
+  ASSERT_THROW(heap.Get(popped), std::invalid_argument);
+
+  auto reused = heap.Emplace(2);
+  auto fresh = heap.Emplace(4);
+  ASSERT_NE(reused, popped);
+  ASSERT_NE(reused, fresh);
+  heap.DecreaseKey(fresh, ThrowingValue(0));
+  ASSERT_EQ(heap.Get(first).value, 3);
+  ASSERT_EQ(heap.Size(), 3);
+
+  std::vector<int> drained;
+  while (!heap.IsEmpty()) {
+    drained.push_back(heap.Top().value);
+    heap.Pop();
+  }
+  ASSERT_EQ(drained, (std::vector<int>{0, 2, 3}));
+}
+
+TEST(DaryHeapCustomTest, Comparator) {
+  DaryHeap<int, 4, std::greater<>> heap{3, 1, 4, 1, 5, 9, 2, 6};
+  ASSERT_EQ(heap.Top(), 9);
+  heap.Pop();
+  ASSERT_EQ(heap.Top(), 6);
+}
+
+TEST(DaryHeapCustomTest, MoveOnlyFriendlyStrings) {
+  DaryHeap<std::string> heap;
+  heap.Push(std::string("task-b"));
+  heap.Emplace("task-a");
+  heap.Push("task-c");
+  ASSERT_EQ(heap.Top(), "task-a");
+}
+
+TEST(DaryHeapCustomTest, Swap) {
+  DaryHeap<int> heap{1, 2};
+  DaryHeap<int> other{5};
+  std::swap(heap, other);
+  ASSERT_EQ(heap.Size(), 1);
+  ASSERT_EQ(other.Size(), 2);
+  ASSERT_EQ(heap.Top(), 5);
+  ASSERT_EQ(other.Top(), 1);
+}
+
+TEST(DaryHeapCustomTest, DijkstraLikeWorkload) {
+  // Random decrease-key interleaved with pops must keep the heap order.
+  // Keys are (distance, vertex) pairs, so the popped vertex is known exactly
+  using Key = std::pair<int, size_t>;
+  std::mt19937 mt(7);
+  DaryHeap<Key, 8> heap;
+  std::vector<DaryHeap<Key, 8>::Handle> handles;
+  std::vector<int> dist;
+  std::vector<bool> alive;
+
+  for (size_t i = 0; i < 2000; ++i) {
+    dist.push_back(static_cast<int>(mt() % 1000000));
+    handles.push_back(heap.Push({dist.back(), i}));
+    alive.push_back(true);
+  }
+
+  int last = 0;
+  while (!heap.IsEmpty()) {
+    for (int j = 0; j < 3; ++j) {
+      size_t idx = mt() % dist.size();
+      if (alive[idx] && dist[idx] > last) {
+        dist[idx] = last + static_cast<int>(mt() % (dist[idx] - last));
+        heap.DecreaseKey(handles[idx], {dist[idx], idx});
+      }
+    }
+    auto [top, vertex] = heap.Top();
+    ASSERT_GE(top, last);
+    ASSERT_EQ(dist[vertex], top);
+    last = top;
+    alive[vertex] = false;
+    heap.Pop();
+  }
+}
+
+
+TEST(HeapSortTest, Empty) {
+  std::vector<int> values;
+  HeapSort(values.begin(), values.end());
+  ASSERT_TRUE(values.empty());
+}
+
+TEST(HeapSortTest, Simple) {
+  std::vector<int> values{5, 3, 9, 1, 0, 7, 3};
+  HeapSort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<int>{0, 1, 3, 3, 5, 7, 9}));
+}
+
+TEST(HeapSortTest, AllSizes) {
+  std::mt19937 mt(42);
+  for (size_t sz = 0; sz < 100; ++sz) {
+    std::vector<int> values(sz);
+    for (auto& value : values) {
+      value = static_cast<int>(mt() % 10);
+    }
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    HeapSort(values.begin(), values.end());
+    ASSERT_EQ(values, expected) << fmt::format("Wrong order for size {}", sz);
+  }
+}
+
+TEST(HeapSortTest, RandomWithComparator) {
+  std::mt19937 mt(42);
+  std::vector<int> values(100000);
+  for (auto& value : values) {
+    value = static_cast<int>(mt());
+  }
+  auto expected = values;
+  std::sort(expected.begin(), expected.end(), std::greater<>());
+  HeapSort(values.begin(), values.end(), std::greater<>());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(HeapSortTest, Strings) {
+  std::vector<std::string> values{"pear", "apple", "fig", "banana", "", "apple"};
+  HeapSort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<std::string>{"", "apple", "apple", "banana", "fig", "pear"}));
+}
+
+TEST(HeapSortTest, SortedAndReversed) {
+  std::vector<int> values(1000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int>(i);
+  }
+  auto expected = values;
+  HeapSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+
+  std::reverse(values.begin(), values.end());
+  HeapSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+
+TEST(PairingHeapTest, DefaultConstructor) {
+  PairingHeap<int> heap;
+  ASSERT_TRUE(heap.IsEmpty()) << "Default heap isn't empty!";
+  EXPECT_THROW({
+    heap.Pop();
+  }, std::runtime_error);
+}
+
+TEST(PairingHeapTest, RandomPushPop) {
+  std::mt19937 mt(42);
+  std::uniform_int_distribution<int> dist(-1000, 1000);
+  PairingHeap<int> heap;
+  std::priority_queue<int, std::vector<int>, std::greater<>> expected;
+
+  for (int i = 0; i < 10000; ++i) {
+    if (expected.empty() || dist(mt) > -300) {
+      int value = dist(mt);
+      heap.Push(value);
+      expected.push(value);
+    } else {
+      ASSERT_EQ(heap.Top(), expected.top());
+      heap.Pop();
+      expected.pop();
+    }
+    ASSERT_EQ(heap.Size(), expected.size());
+  }
+}
+
+TEST(PairingHeapTest, Meld) {
+  PairingHeap<int> heap{5, 1, 9};
+  PairingHeap<int> other{4, 0, 7};
+  auto handle = other.Push(8);
+
+  heap.Meld(other);
+  ASSERT_TRUE(other.IsEmpty());
+  ASSERT_EQ(heap.Size(), 7);
+
+  // Handle of the melded element now works with the receiving heap
+  heap.DecreaseKey(handle, -1);
+  ASSERT_EQ(Drain(heap), (std::vector<int>{-1, 0, 1, 4, 5, 7, 9}));
+
+  // Melded-from heap is reusable
+  other.Push(3);
+  ASSERT_EQ(other.Top(), 3);
+}
+
+// A worker heap gets one element, melds it into the receiver, and the
+// receiver pops it: every round gives the receiver the worker's new slab
+TEST(PoolAllocatorTest, SlabsBoundedUnderSmallSplices) {
+  PoolAllocator<int, 16> receiver;
+  PoolAllocator<int, 16> worker;
+  for (int i = 0; i < 200000; ++i) {
+    int* value = worker.New(i);
+    receiver.Splice(worker);
+    ASSERT_EQ(worker.SlabCount(), 0);
+    receiver.Delete(value);
+    ASSERT_LE(receiver.SlabCount(), 2);
+  }
+}
+
+// Spare cells of a spliced slab are used by the receiver
+TEST(PoolAllocatorTest, SplicedSlabsAreReused) {
+  PoolAllocator<int, 16> receiver;
+  PoolAllocator<int, 16> worker;
+  std::vector<int*> values{worker.New(0)};
+  receiver.Splice(worker);
+  for (int i = 1; i < 16; ++i) {
+    values.push_back(receiver.New(i));
+  }
+  ASSERT_EQ(receiver.SlabCount(), 1);
+
+  std::vector<int*> more;
+  for (int i = 0; i < 1000; ++i) {
+    more.push_back(receiver.New(i));
+  }
+  for (int* value : more) {
+    receiver.Delete(value);
+  }
+  ASSERT_LE(receiver.SlabCount(), 2);
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_EQ(*values[i], i);
+  }
+}
+
+TEST(PairingHeapTest, ManySmallMelds) {
+  PairingHeap<int> heap;
+  PairingHeap<int> worker;
+  for (int i = 0; i < 200000; ++i) {
+    worker.Push(i);
+    heap.Meld(worker);
+    ASSERT_EQ(heap.Top(), i);
+    heap.Pop();
+  }
+  ASSERT_TRUE(heap.IsEmpty());
+}
+
+TEST(PairingHeapTest, MeldEmpty) {
+  PairingHeap<int> heap;
+  PairingHeap<int> other{2, 1};
+  heap.Meld(other);
+  ASSERT_EQ(heap.Top(), 1);
+  heap.Meld(other);
+  ASSERT_EQ(heap.Size(), 2);
+  heap.Meld(heap);
+  ASSERT_EQ(heap.Size(), 2);
+}
+
+TEST(PairingHeapTest, ManyMelds) {
+  std::mt19937 mt(42);
+  std::vector<PairingHeap<int>> workers(16);
+  std::vector<int> expected;
+  for (int i = 0; i < 16000; ++i) {
+    int value = static_cast<int>(mt() % 100000);
+    workers[i % workers.size()].Push(value);
+    expected.push_back(value);
+  }
+
+  PairingHeap<int> heap;
+  for (auto& worker : workers) {
+    heap.Meld(std::move(worker));
+  }
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(Drain(heap), expected);
+}
+
+TEST(PairingHeapTest, DecreaseKey) {
+  PairingHeap<int> heap;
+  std::vector<PairingHeap<int>::Handle> handles;
+  for (int i = 0; i < 100; ++i) {
+    handles.push_back(heap.Push(i + 100));
+  }
+  heap.Pop();  // builds a non-trivial tree
+
+  heap.DecreaseKey(handles[50], 1);
+  ASSERT_EQ(heap.Top(), 1);
+  heap.DecreaseKey(handles[99], 0);
+  ASSERT_EQ(heap.Top(), 0);
+  heap.Pop();
+  ASSERT_EQ(heap.Top(), 1);
+  ASSERT_EQ(heap.Get(handles[98]), 198);
+
+  EXPECT_THROW({
+    heap.DecreaseKey(handles[10], 1000);
+  }, std::invalid_argument);
+}
+
+TEST(PairingHeapTest, DijkstraLikeWorkload) {
+  using Key = std::pair<int, size_t>;
+  std::mt19937 mt(7);
+  PairingHeap<Key> heap;
+  std::vector<PairingHeap<Key>::Handle> handles;
+  std::vector<int> dist;
+  std::vector<bool> alive;
+
+  for (size_t i = 0; i < 2000; ++i) {
+    dist.push_back(static_cast<int>(mt() % 1000000));
+    handles.push_back(heap.Push({dist.back(), i}));
+    alive.push_back(true);
+  }
+
+  int last = 0;
+  while (!heap.IsEmpty()) {
+    for (int j = 0; j < 3; ++j) {
+      size_t idx = mt() % dist.size();
+      if (alive[idx] && dist[idx] > last) {
+        dist[idx] = last + static_cast<int>(mt() % (dist[idx] - last));
+        heap.DecreaseKey(handles[idx], {dist[idx], idx});
+      }
+    }
+    auto [top, vertex] = heap.Top();
+    ASSERT_GE(top, last);
+    ASSERT_EQ(dist[vertex], top);
+    last = top;
+    alive[vertex] = false;
+    heap.Pop();
+  }
+}
+
+TEST(PairingHeapTest, NonTrivialValues) {
+  // Leak check for ASan: Clear and destructor must destroy the strings
+  PairingHeap<std::string> heap;
+  for (int i = 0; i < 1000; ++i) {
+    heap.Push(fmt::format("a long enough string to be on the heap #{}", i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    heap.Pop();
+  }
+  PairingHeap<std::string> other;
+  other.Push("zzz");
+  heap.Meld(other);
+  heap.Clear();
+  ASSERT_TRUE(heap.IsEmpty());
+  heap.Push("again");
+  ASSERT_EQ(heap.Top(), "again");
+}
+
+TEST(PairingHeapTest, SortedInputDeepTree) {
+  // Descending pushes make a root with a huge child list:
+  // Pop and Clear must not recurse
+  PairingHeap<int> heap;
+  for (int i = 1000000; i > 0; --i) {
+    heap.Push(i);
+  }
+  heap.Pop();
+  ASSERT_EQ(heap.Top(), 2);
+}
+
+TEST(PairingHeapTest, Swap) {
+  PairingHeap<int> heap{1, 2};
+  PairingHeap<int> other{5};
+  std::swap(heap, other);
+  ASSERT_EQ(heap.Top(), 5);
+  ASSERT_EQ(other.Top(), 1);
+}
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace detail::parallel {
+
+// Below this many elements per thread spawning threads costs more than it saves
+inline constexpr size_t kMinPerThread = 1 << 14;
+
+// Every bucket gets this many samples: more samples give more even buckets
+inline constexpr size_t kOversampling = 32;
+
+// Runs task(0), ..., task(threads - 1) on separate threads, task(0) on the caller
+template <typename Task>
+void ParallelFor(size_t threads, Task&& task) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(task, t);
+    }
+    task(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+inline size_t ChunkBegin(size_t size, size_t chunks, size_t index) noexcept {
+    return size / chunks * index + std::min(index, size % chunks);
+}
+
+inline size_t ClampThreads(size_t threads, size_t size) noexcept {
+    threads = std::max<size_t>(threads, 1);
+    return std::max<size_t>(1, std::min(threads, size / kMinPerThread));
+}
+
+// Sequential k-way merge of sorted runs through a binary heap of run indices.
+// Equal elements are taken from the run with the smaller index first.
+template <typename RandomIt, typename OutputIt, typename Compare>
+OutputIt MergeRuns(std::vector<std::pair<RandomIt, RandomIt>> runs, OutputIt out, Compare& comp) {
+    // Heap order: the run with the greater head goes down
+    auto later = [&](size_t a, size_t b) {
+        if (comp(*runs[b].first, *runs[a].first)) {
+            return true;
+        }
+        return !comp(*runs[a].first, *runs[b].first) && b < a;
+    };
+
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].first != runs[i].second) {
+            heap.push_back(i);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    while (heap.size() > 1) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto& run = runs[heap.back()];
+        *out = *run.first;
+        ++out;
+        if (++run.first == run.second) {
+            heap.pop_back();
+        } else {
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+
+    if (!heap.empty()) {
+        out = std::copy(runs[heap.front()].first, runs[heap.front()].second, out);
+    }
+    return out;
+}
+
+}  // namespace detail::parallel
+
+// Parallel sample sort.
+//
+// 1) Splitters: (threads * kOversampling) evenly spaced elements are sorted,
+//    every kOversampling-th of them becomes a splitter between buckets.
+// 2) Classification: every thread counts how many elements of its own chunk
+//    fall into each bucket.
+// 3) Prefix sums over (bucket, thread) give every thread private ranges
+//    in the buffer, so the scatter needs no locks.
+// 4) Every thread sorts one bucket and moves it back into place.
+//
+// Not stable. Many copies of one key all fall into one bucket: the sort stays
+// correct, but that bucket is sorted by a single thread.
+template <typename RandomIt, typename Compare = std::less<>>
+void ParallelSort(RandomIt first, RandomIt last, Compare comp = Compare(),
+                  size_t threads = std::thread::hardware_concurrency()) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    using detail::parallel::ChunkBegin;
+    using detail::parallel::kOversampling;
+    using detail::parallel::ParallelFor;
+
+    size_t size = std::distance(first, last);
+    threads = detail::parallel::ClampThreads(threads, size);
+
+    if (threads == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    const size_t buckets = threads;
+
+    // 1) Splitters from an evenly spaced oversample
+    std::vector<T> sample;
+    sample.reserve(buckets * kOversampling);
+    for (size_t i = 0; i < buckets * kOversampling; ++i) {
+        sample.push_back(first[i * size / (buckets * kOversampling)]);
+    }
+    std::sort(sample.begin(), sample.end(), comp);
+
+    std::vector<T> splitters;
+    splitters.reserve(buckets - 1);
+    for (size_t b = 1; b < buckets; ++b) {
+        splitters.push_back(sample[b * kOversampling]);
+    }
+
+    auto bucket_of = [&](const T& value) -> size_t {
+        return std::upper_bound(splitters.begin(), splitters.end(), value, comp) - splitters.begin();
+    };
+
+    // 2) Per-thread bucket sizes
+    std::vector<std::vector<size_t>> offsets(threads, std::vector<size_t>(buckets, 0));
+    ParallelFor(threads, [&](size_t t) {
+        for (size_t i = ChunkBegin(size, threads, t); i < ChunkBegin(size, threads, t + 1); ++i) {
+            ++offsets[t][bucket_of(first[i])];
+        }
+    });
+
+    // 3) Exclusive prefix sum in (bucket, thread) order
+    std::vector<size_t> bucket_begin(buckets + 1, 0);
+    size_t offset = 0;
+    for (size_t b = 0; b < buckets; ++b) {
+        bucket_begin[b] = offset;
+        for (size_t t = 0; t < threads; ++t) {
+            size_t count = offsets[t][b];
+            offsets[t][b] = offset;
+            offset += count;
+        }
+    }
+    bucket_begin[buckets] = size;
+
+    std::vector<T> buffer(size);
+    ParallelFor(threads, [&](size_t t) {
+        for (size_t i = ChunkBegin(size, threads, t); i < ChunkBegin(size, threads, t + 1); ++i) {
+            buffer[offsets[t][bucket_of(first[i])]++] = std::move(first[i]);
+        }
+    });
+
+    // 4) Buckets are sorted independently and copied out
+    ParallelFor(threads, [&](size_t b) {
+        auto bucket_first = buffer.begin() + bucket_begin[b];
+        auto bucket_last = buffer.begin() + bucket_begin[b + 1];
+        std::sort(bucket_first, bucket_last, comp);
+        std::move(bucket_first, bucket_last, first + bucket_begin[b]);
+    });
+}
+
+// Parallel merge of k sorted ranges into out.
+//
+// Splitters sampled from all ranges cut every range into `threads` parts
+// with upper_bound, so that parts with equal index hold the same key interval.
+// Every thread merges its parts into its own place of the output.
+// Equal elements keep the order of ranges, so the merge is stable.
+// Threads write at offsets of out, so it must be random access too.
+template <typename RandomIt, typename RandomOutIt, typename Compare = std::less<>>
+RandomOutIt ParallelMultiwayMerge(const std::vector<std::pair<RandomIt, RandomIt>>& ranges, RandomOutIt out,
+                                  Compare comp = Compare(), size_t threads = std::thread::hardware_concurrency()) {
+    static_assert(std::random_access_iterator<RandomIt>, "Ranges must be random access: they are cut by binary search");
+    static_assert(std::random_access_iterator<RandomOutIt>, "Output must be random access: threads write at offsets");
+
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    using detail::parallel::kOversampling;
+    using detail::parallel::ParallelFor;
+
+    size_t total = 0;
+    for (const auto& [first, last] : ranges) {
+        total += std::distance(first, last);
+    }
+    threads = detail::parallel::ClampThreads(threads, total);
+
+    if (threads == 1) {
+        return detail::parallel::MergeRuns(ranges, out, comp);
+    }
+
+    // Samples from every range in proportion to its length
+    std::vector<T> sample;
+    for (const auto& [first, last] : ranges) {
+        size_t len = std::distance(first, last);
+        size_t count = (len * threads * kOversampling + total - 1) / total;
+        for (size_t i = 0; i < count; ++i) {
+            sample.push_back(first[i * len / count]);
+        }
+    }
+    std::sort(sample.begin(), sample.end(), comp);
+
+    // cuts[t][r] - where part t of range r begins
+    std::vector<std::vector<RandomIt>> cuts(threads + 1);
+    cuts[0].reserve(ranges.size());
+    cuts[threads].reserve(ranges.size());
+    for (const auto& [first, last] : ranges) {
+        cuts[0].push_back(first);
+        cuts[threads].push_back(last);
+    }
+    for (size_t t = 1; t < threads; ++t) {
+        const T& splitter = sample[t * sample.size() / threads];
+        for (const auto& [first, last] : ranges) {
+            cuts[t].push_back(std::upper_bound(first, last, splitter, comp));
+        }
+    }
+
+    // Output offset of every part
+    std::vector<size_t> out_begin(threads + 1, 0);
+    for (size_t t = 0; t < threads; ++t) {
+        size_t len = 0;
+        for (size_t r = 0; r < ranges.size(); ++r) {
+            len += std::distance(cuts[t][r], cuts[t + 1][r]);
+        }
+        out_begin[t + 1] = out_begin[t] + len;
+    }
+
+    ParallelFor(threads, [&](size_t t) {
+        std::vector<std::pair<RandomIt, RandomIt>> parts;
+        parts.reserve(ranges.size());
+        for (size_t r = 0; r < ranges.size(); ++r) {
+            parts.emplace_back(cuts[t][r], cuts[t + 1][r]);
+        }
+        auto part_comp = comp;
+        detail::parallel::MergeRuns(std::move(parts), out + out_begin[t], part_comp);
+    });
+
+    return out + total;
+}
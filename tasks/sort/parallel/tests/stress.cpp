@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../parallel_sort.hpp"
+
+constexpr int kSize = 1 << 24;
+
+std::vector<int64_t> ConstructRandomVector(int sz) {
+  std::random_device rd;
+  std::mt19937_64 mt(rd());
+  std::vector<int64_t> res(sz);
+  for (auto& val : res) {
+    val = static_cast<int64_t>(mt());
+  }
+  return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void BM_StdSort(benchmark::State& state) {
+  auto values = ConstructRandomVector(kSize);
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    std::sort(copy.begin(), copy.end());
+  }
+}
+
+// Arg: number of threads
+void BM_ParallelSort(benchmark::State& state) {
+  auto values = ConstructRandomVector(kSize);
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    ParallelSort(copy.begin(), copy.end(), std::less<>(), state.range(0));
+  }
+  state.counters["threads"] = static_cast<double>(state.range(0));
+}
+
+// Arg: number of threads, 64 sorted runs of equal length are merged
+void BM_ParallelMultiwayMerge(benchmark::State& state) {
+  constexpr size_t kRuns = 64;
+  auto values = ConstructRandomVector(kSize);
+  using It = std::vector<int64_t>::const_iterator;
+  std::vector<std::pair<It, It>> ranges;
+  for (size_t r = 0; r < kRuns; ++r) {
+    auto first = values.begin() + r * values.size() / kRuns;
+    auto last = values.begin() + (r + 1) * values.size() / kRuns;
+    std::sort(first, last);
+    ranges.emplace_back(first, last);
+  }
+
+  std::vector<int64_t> out(values.size());
+  for (auto _ : state) {
+    ParallelMultiwayMerge(ranges, out.begin(), std::less<>(), state.range(0));
+  }
+  state.counters["threads"] = static_cast<double>(state.range(0));
+}
+
+
+BENCHMARK(BM_StdSort)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ParallelSort)->RangeMultiplier(2)->Range(1, 64)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ParallelMultiwayMerge)->RangeMultiplier(2)->Range(1, 64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../parallel_sort.hpp"
+
+std::vector<int64_t> RandomVector(size_t sz, int64_t max = INT64_MAX) {
+  std::mt19937_64 mt(42);
+  std::uniform_int_distribution<int64_t> dist(-max, max);
+  std::vector<int64_t> res(sz);
+  for (auto& val : res) {
+    val = dist(mt);
+  }
+  return res;
+}
+
+
+TEST(ParallelSortTest, Empty) {
+  std::vector<int> values;
+  ParallelSort(values.begin(), values.end(), std::less<>(), 4);
+  ASSERT_TRUE(values.empty());
+}
+
+TEST(ParallelSortTest, SmallInputIsSequential) {
+  std::vector<int> values{5, 3, 9, 1, 0, 7, 3};
+  ParallelSort(values.begin(), values.end(), std::less<>(), 8);
+  ASSERT_EQ(values, (std::vector<int>{0, 1, 3, 3, 5, 7, 9}));
+}
+
+TEST(ParallelSortTest, RandomAnyThreads) {
+  auto values = RandomVector(1 << 18);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+
+  for (size_t threads : {1, 2, 3, 4, 7, 16}) {
+    auto copy = values;
+    ParallelSort(copy.begin(), copy.end(), std::less<>(), threads);
+    ASSERT_EQ(copy, expected) << fmt::format("Wrong order with {} threads", threads);
+  }
+}
+
+TEST(ParallelSortTest, ManyDuplicates) {
+  auto values = RandomVector(1 << 17, 3);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  ParallelSort(values.begin(), values.end(), std::less<>(), 8);
+  ASSERT_EQ(values, expected);
+}
+
+TEST(ParallelSortTest, SortedAndReversed) {
+  std::vector<int> values(1 << 17);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int>(i);
+  }
+  auto expected = values;
+  ParallelSort(values.begin(), values.end(), std::less<>(), 4);
+  ASSERT_EQ(values, expected);
+
+  std::reverse(values.begin(), values.end());
+  ParallelSort(values.begin(), values.end(), std::less<>(), 4);
+  ASSERT_EQ(values, expected);
+}
+
+TEST(ParallelSortTest, StringsWithComparator) {
+  std::mt19937 mt(42);
+  std::vector<std::string> values(1 << 16);
+  for (auto& str : values) {
+    str = std::to_string(mt());
+  }
+  auto expected = values;
+  std::sort(expected.begin(), expected.end(), std::greater<>());
+  ParallelSort(values.begin(), values.end(), std::greater<>(), 4);
+  ASSERT_EQ(values, expected);
+}
+
+TEST(ParallelMultiwayMergeTest, MergesSortedRanges) {
+  std::mt19937 mt(42);
+  std::vector<std::vector<int64_t>> runs;
+  std::vector<int64_t> expected;
+  for (size_t i = 0; i < 9; ++i) {
+    runs.push_back(RandomVector(10000 * (i + 1) + mt() % 1000, 1000));
+    std::sort(runs.back().begin(), runs.back().end());
+    expected.insert(expected.end(), runs.back().begin(), runs.back().end());
+  }
+  runs.emplace_back();  // empty range
+  std::sort(expected.begin(), expected.end());
+
+  using It = std::vector<int64_t>::const_iterator;
+  std::vector<std::pair<It, It>> ranges;
+  for (const auto& run : runs) {
+    ranges.emplace_back(run.begin(), run.end());
+  }
+
+  for (size_t threads : {1, 2, 5, 8}) {
+    std::vector<int64_t> out(expected.size());
+    auto end = ParallelMultiwayMerge(ranges, out.begin(), std::less<>(), threads);
+    ASSERT_EQ(end, out.end());
+    ASSERT_EQ(out, expected) << fmt::format("Wrong merge with {} threads", threads);
+  }
+}
+
+TEST(ParallelMultiwayMergeTest, Stable) {
+  // Pairs are compared by key only: equal keys must keep the order of ranges
+  using Item = std::pair<int, size_t>;
+  auto by_key = [](const Item& a, const Item& b) {
+    return a.first < b.first;
+  };
+
+  std::mt19937 mt(42);
+  std::vector<std::vector<Item>> runs(4);
+  for (size_t r = 0; r < runs.size(); ++r) {
+    for (size_t i = 0; i < 50000; ++i) {
+      runs[r].push_back({static_cast<int>(mt() % 100), r});
+    }
+    std::sort(runs[r].begin(), runs[r].end(), by_key);
+  }
+
+  using It = std::vector<Item>::const_iterator;
+  std::vector<std::pair<It, It>> ranges;
+  for (const auto& run : runs) {
+    ranges.emplace_back(run.begin(), run.end());
+  }
+
+  std::vector<Item> out(200000);
+  ParallelMultiwayMerge(ranges, out.begin(), by_key, 4);
+  for (size_t i = 1; i < out.size(); ++i) {
+    ASSERT_TRUE(out[i - 1].first < out[i].first ||
+                (out[i - 1].first == out[i].first && out[i - 1].second <= out[i].second))
+        << fmt::format("Order is broken on {} index", i);
+  }
+}
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail::radix {
+
+// Signed keys are mapped to unsigned ones with flipped sign bit,
+// so that the unsigned order of the images matches the signed order of keys
+template <typename T>
+inline auto ToUnsigned(T value) noexcept {
+    using UInt = std::make_unsigned_t<T>;
+
+    if constexpr (std::is_signed_v<T>) {
+        return static_cast<UInt>(static_cast<UInt>(value) ^ (UInt{1} << (sizeof(T) * CHAR_BIT - 1)));
+    } else {
+        return static_cast<UInt>(value);
+    }
+}
+
+template <typename T, size_t DigitBits>
+struct Digits {
+    static constexpr size_t kBuckets = size_t{1} << DigitBits;
+    static constexpr size_t kMask = kBuckets - 1;
+    static constexpr size_t kPasses = (sizeof(T) * CHAR_BIT + DigitBits - 1) / DigitBits;
+
+    static inline size_t Get(T value, size_t pass) noexcept {
+        return static_cast<size_t>(ToUnsigned(value) >> (pass * DigitBits)) & kMask;
+    }
+};
+
+template <size_t Buckets>
+using Histogram = std::array<size_t, Buckets>;
+
+// Pass is trivial when all keys share the same digit: the scatter would copy
+// the array to itself, so it can be skipped
+template <size_t Buckets>
+inline bool IsTrivialPass(const Histogram<Buckets>& hist, size_t size) noexcept {
+    for (size_t count : hist) {
+        if (count == size) {
+            return true;
+        }
+        if (count != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+template <size_t Buckets>
+inline void ExclusivePrefixSum(Histogram<Buckets>& hist) noexcept {
+    size_t sum = 0;
+    for (size_t& count : hist) {
+        size_t next = sum + count;
+        count = sum;
+        sum = next;
+    }
+}
+
+// Symbol of a string at position depth, 0 is reserved for the end of string
+inline size_t CharAt(std::string_view str, size_t depth) noexcept {
+    return depth < str.size() ? static_cast<unsigned char>(str[depth]) + 1 : 0;
+}
+
+inline bool LessFrom(std::string_view a, std::string_view b, size_t depth) noexcept {
+    return a.substr(depth) < b.substr(depth);
+}
+
+template <typename RandomIt>
+void InsertionSortFrom(RandomIt first, RandomIt last, size_t depth) {
+    if (first == last) {
+        return;
+    }
+
+    for (RandomIt it = std::next(first); it != last; ++it) {
+        auto value = std::move(*it);
+        RandomIt hole = it;
+
+        while (hole != first && LessFrom(value, *std::prev(hole), depth)) {
+            *hole = std::move(*std::prev(hole));
+            --hole;
+        }
+        *hole = std::move(value);
+    }
+}
+
+// Buckets smaller than this are sorted by insertion sort: 257 counters
+// per call cost more than a few comparisons on a short suffix
+inline constexpr size_t kMsdInsertionThreshold = 32;
+inline constexpr size_t kAlphabet = 257;
+
+// Strings [first + begin, first + end) share the first depth symbols
+struct MsdRange {
+    size_t begin;
+    size_t end;
+    size_t depth;
+};
+
+// Length of the prefix shared by all strings of the range, not less than depth
+template <typename RandomIt>
+size_t CommonPrefix(RandomIt first, RandomIt last, size_t depth) noexcept {
+    std::string_view head = *first;
+    size_t common = head.size();
+    for (RandomIt it = std::next(first); it != last && common > depth; ++it) {
+        std::string_view str = *it;
+        size_t len = depth;
+        size_t limit = std::min(common, str.size());
+        while (len < limit && str[len] == head[len]) {
+            ++len;
+        }
+        common = len;
+    }
+    return common;
+}
+
+// Iterative: the work stack holds ranges instead of recursion frames, so
+// neither long common prefixes nor deep buckets grow the call stack
+template <typename RandomIt, typename Buffer>
+void MsdSort(RandomIt first, RandomIt last, size_t depth, Buffer& aux) {
+    Histogram<kAlphabet + 1> offsets;
+    std::vector<MsdRange> ranges{{0, static_cast<size_t>(std::distance(first, last)), depth}};
+
+    while (!ranges.empty()) {
+        MsdRange range = ranges.back();
+        ranges.pop_back();
+
+        RandomIt begin = first + range.begin;
+        RandomIt end = first + range.end;
+        size_t size = range.end - range.begin;
+
+        if (size <= kMsdInsertionThreshold) {
+            InsertionSortFrom(begin, end, range.depth);
+            continue;
+        }
+
+        offsets.fill(0);
+        for (RandomIt it = begin; it != end; ++it) {
+            ++offsets[CharAt(*it, range.depth) + 1];
+        }
+
+        // All strings share the symbol: skip the whole shared prefix at once
+        if (std::find(offsets.begin(), offsets.end(), size) != offsets.end()) {
+            if (offsets[1] != size) {  // not every string ended
+                ranges.push_back({range.begin, range.end, CommonPrefix(begin, end, range.depth)});
+            }
+            continue;
+        }
+
+        for (size_t i = 1; i <= kAlphabet; ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+
+        // Bucket 0 holds ended strings, they are equal already
+        for (size_t symbol = 1; symbol < kAlphabet; ++symbol) {
+            if (offsets[symbol + 1] - offsets[symbol] > 1) {
+                ranges.push_back({range.begin + offsets[symbol], range.begin + offsets[symbol + 1], range.depth + 1});
+            }
+        }
+
+        for (RandomIt it = begin; it != end; ++it) {
+            aux[offsets[CharAt(*it, range.depth)]++] = std::move(*it);
+        }
+        for (size_t i = 0; i < size; ++i) {
+            begin[i] = std::move(aux[i]);
+        }
+    }
+}
+
+}  // namespace detail::radix
+
+// LSD radix sort for fixed-width integer keys.
+// DigitBits is the width of one digit: 8 and 11 bits keep the histogram in L1,
+// 16 bits halves the number of passes for 32-bit keys.
+// Passes where all keys have the same digit are skipped.
+template <size_t DigitBits = 8, typename RandomIt>
+void LsdRadixSort(RandomIt first, RandomIt last) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    using Digits = detail::radix::Digits<T, DigitBits>;
+    using Histogram = detail::radix::Histogram<Digits::kBuckets>;
+
+    static_assert(std::is_integral_v<T>, "LsdRadixSort expects integral keys");
+    static_assert(DigitBits > 0 && DigitBits <= 16, "Digit must fit in 1..16 bits");
+
+    size_t size = std::distance(first, last);
+    if (size < 2) {
+        return;
+    }
+
+    // One read of the input builds histograms for every pass at once
+    std::vector<Histogram> hists(Digits::kPasses);
+    for (RandomIt it = first; it != last; ++it) {
+        for (size_t pass = 0; pass < Digits::kPasses; ++pass) {
+            ++hists[pass][Digits::Get(*it, pass)];
+        }
+    }
+
+    std::vector<T> buffer(size);
+    T* src = &*first;
+    T* dst = buffer.data();
+
+    for (size_t pass = 0; pass < Digits::kPasses; ++pass) {
+        if (detail::radix::IsTrivialPass(hists[pass], size)) {
+            continue;
+        }
+
+        Histogram& offsets = hists[pass];
+        detail::radix::ExclusivePrefixSum(offsets);
+
+        for (size_t i = 0; i < size; ++i) {
+            dst[offsets[Digits::Get(src[i], pass)]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != &*first) {
+        std::copy(src, src + size, first);
+    }
+}
+
+// MSD radix sort for strings (std::string, std::string_view, ...).
+// Orders strings lexicographically by unsigned bytes, as std::string does.
+template <typename RandomIt>
+void MsdRadixSort(RandomIt first, RandomIt last) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+
+    if (std::distance(first, last) < 2) {
+        return;
+    }
+
+    std::vector<T> aux(std::distance(first, last));
+    detail::radix::MsdSort(first, last, 0, aux);
+}
+
+// LSD radix sort with histograms and scatter split between threads.
+// Every thread counts digits of its own chunk, then the prefix sum over
+// (digit, thread) gives each thread private output ranges, so the scatter
+// needs no synchronization.
+template <size_t DigitBits = 8, typename RandomIt>
+void ParallelLsdRadixSort(RandomIt first, RandomIt last, size_t threads = std::thread::hardware_concurrency()) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    using Digits = detail::radix::Digits<T, DigitBits>;
+    using Histogram = detail::radix::Histogram<Digits::kBuckets>;
+
+    static_assert(std::is_integral_v<T>, "ParallelLsdRadixSort expects integral keys");
+    static_assert(DigitBits > 0 && DigitBits <= 16, "Digit must fit in 1..16 bits");
+
+    size_t size = std::distance(first, last);
+    threads = std::max<size_t>(1, std::min(threads, size / Digits::kBuckets));
+
+    if (threads == 1) {
+        LsdRadixSort<DigitBits>(first, last);
+        return;
+    }
+
+    std::vector<T> buffer(size);
+    T* src = &*first;
+    T* dst = buffer.data();
+
+    size_t chunk = (size + threads - 1) / threads;
+    std::vector<Histogram> local(threads);
+
+    auto run = [threads](auto&& task) {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back(task, t);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    for (size_t pass = 0; pass < Digits::kPasses; ++pass) {
+        run([&](size_t t) {
+            local[t].fill(0);
+            size_t begin = std::min(size, t * chunk);
+            size_t end = std::min(size, begin + chunk);
+            for (size_t i = begin; i < end; ++i) {
+                ++local[t][Digits::Get(src[i], pass)];
+            }
+        });
+
+        Histogram total{};
+        for (const Histogram& hist : local) {
+            for (size_t digit = 0; digit < Digits::kBuckets; ++digit) {
+                total[digit] += hist[digit];
+            }
+        }
+        if (detail::radix::IsTrivialPass(total, size)) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < Digits::kBuckets; ++digit) {
+            for (size_t t = 0; t < threads; ++t) {
+                size_t count = local[t][digit];
+                local[t][digit] = offset;
+                offset += count;
+            }
+        }
+
+        run([&](size_t t) {
+            Histogram& offsets = local[t];
+            size_t begin = std::min(size, t * chunk);
+            size_t end = std::min(size, begin + chunk);
+            for (size_t i = begin; i < end; ++i) {
+                dst[offsets[Digits::Get(src[i], pass)]++] = src[i];
+            }
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != &*first) {
+        std::copy(src, src + size, first);
+    }
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../radix_sort.hpp"
+
+template <typename T>
+std::vector<T> ConstructRandomVector(int sz) {
+  std::random_device rd;
+  std::mt19937_64 mt(rd());
+  std::uniform_int_distribution<T> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+  std::vector<T> res(sz);
+  for (auto& val : res) {
+    val = dist(mt);
+  }
+  return res;
+}
+
+std::vector<std::string> ConstructRandomStrings(int sz) {
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<size_t> len(1, 16);
+  std::uniform_int_distribution<int> symbol('a', 'z');
+  std::vector<std::string> res(sz);
+  for (auto& str : res) {
+    str.resize(len(mt));
+    for (auto& ch : str) {
+      ch = static_cast<char>(symbol(mt));
+    }
+  }
+  return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void BM_StdSort(benchmark::State& state) {
+  auto values = ConstructRandomVector<T>(state.range(0));
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    std::sort(copy.begin(), copy.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+template <typename T, size_t DigitBits>
+void BM_LsdRadixSort(benchmark::State& state) {
+  auto values = ConstructRandomVector<T>(state.range(0));
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    LsdRadixSort<DigitBits>(copy.begin(), copy.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+template <typename T>
+void BM_ParallelLsdRadixSort(benchmark::State& state) {
+  auto values = ConstructRandomVector<T>(state.range(0));
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    ParallelLsdRadixSort(copy.begin(), copy.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdSortStrings(benchmark::State& state) {
+  auto values = ConstructRandomStrings(state.range(0));
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    std::sort(copy.begin(), copy.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_MsdRadixSortStrings(benchmark::State& state) {
+  auto values = ConstructRandomStrings(state.range(0));
+  auto copy = values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = values;
+    state.ResumeTiming();
+    MsdRadixSort(copy.begin(), copy.end());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+
+BENCHMARK(BM_StdSort<int32_t>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LsdRadixSort<int32_t, 8>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LsdRadixSort<int32_t, 11>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LsdRadixSort<int32_t, 16>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParallelLsdRadixSort<int32_t>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdSort<uint64_t>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LsdRadixSort<uint64_t, 8>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LsdRadixSort<uint64_t, 11>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LsdRadixSort<uint64_t, 16>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParallelLsdRadixSort<uint64_t>)->RangeMultiplier(4)->Range(1<<16, 1<<26)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdSortStrings)->RangeMultiplier(4)->Range(1<<16, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MsdRadixSortStrings)->RangeMultiplier(4)->Range(1<<16, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../radix_sort.hpp"
+
+template <typename T>
+std::vector<T> RandomVector(size_t sz, T min = std::numeric_limits<T>::min(),
+                            T max = std::numeric_limits<T>::max()) {
+  std::mt19937_64 mt(42);
+  std::uniform_int_distribution<T> dist(min, max);
+  std::vector<T> res(sz);
+  for (auto& val : res) {
+    val = dist(mt);
+  }
+  return res;
+}
+
+std::vector<std::string> RandomStrings(size_t sz, size_t max_len, char min = 'a', char max = 'z') {
+  std::mt19937 mt(42);
+  std::uniform_int_distribution<size_t> len(0, max_len);
+  std::uniform_int_distribution<int> symbol(min, max);
+  std::vector<std::string> res(sz);
+  for (auto& str : res) {
+    str.resize(len(mt));
+    for (auto& ch : str) {
+      ch = static_cast<char>(symbol(mt));
+    }
+  }
+  return res;
+}
+
+
+TEST(LsdRadixSortTest, Empty) {
+  std::vector<int> values;
+  LsdRadixSort(values.begin(), values.end());
+  ASSERT_TRUE(values.empty());
+}
+
+TEST(LsdRadixSortTest, Simple) {
+  std::vector<int> values{5, 3, 9, 1, 0, 7, 3};
+  LsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<int>{0, 1, 3, 3, 5, 7, 9}));
+}
+
+TEST(LsdRadixSortTest, NegativeKeys) {
+  std::vector<int> values{-5, 3, INT32_MIN, -1, 0, INT32_MAX, 3};
+  LsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<int>{INT32_MIN, -5, -1, 0, 3, 3, INT32_MAX}));
+}
+
+TEST(LsdRadixSortTest, RandomInt32) {
+  auto values = RandomVector<int32_t>(100000);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  LsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(LsdRadixSortTest, RandomUInt64AllDigitWidths) {
+  auto values = RandomVector<uint64_t>(100000);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+
+  auto eight = values;
+  LsdRadixSort<8>(eight.begin(), eight.end());
+  ASSERT_EQ(eight, expected);
+
+  auto eleven = values;
+  LsdRadixSort<11>(eleven.begin(), eleven.end());
+  ASSERT_EQ(eleven, expected);
+
+  auto sixteen = values;
+  LsdRadixSort<16>(sixteen.begin(), sixteen.end());
+  ASSERT_EQ(sixteen, expected);
+}
+
+TEST(LsdRadixSortTest, TrivialPassesSkipped) {
+  // Only the lowest byte differs: odd number of real passes
+  // must still leave the result in the input range
+  auto values = RandomVector<uint64_t>(10000, 0, 255);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  LsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(LsdRadixSortTest, AllEqual) {
+  std::vector<int64_t> values(1000, -7);
+  LsdRadixSort<11>(values.begin(), values.end());
+  ASSERT_EQ(values, std::vector<int64_t>(1000, -7));
+}
+
+TEST(LsdRadixSortTest, SmallTypes) {
+  auto bytes = RandomVector<int16_t>(10000);
+  auto expected = bytes;
+  std::sort(expected.begin(), expected.end());
+  LsdRadixSort<11>(bytes.begin(), bytes.end());
+  ASSERT_EQ(bytes, expected);
+}
+
+TEST(MsdRadixSortTest, Simple) {
+  std::vector<std::string> values{"banana", "apple", "", "app", "b", "apple", "ba"};
+  MsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<std::string>{"", "app", "apple", "apple", "b", "ba", "banana"}));
+}
+
+TEST(MsdRadixSortTest, RandomShortStrings) {
+  auto values = RandomStrings(50000, 8);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  MsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(MsdRadixSortTest, CommonPrefixAndBinaryBytes) {
+  auto values = RandomStrings(20000, 4, -128, 127);
+  for (auto& str : values) {
+    str = "prefix/" + str;
+  }
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  MsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+// Every string is one symbol longer than the shared prefix of the others:
+// 5000 levels of buckets must not take 5000 stack frames
+TEST(MsdRadixSortTest, Staircase) {
+  std::vector<std::string> values;
+  for (int j = 4999; j >= 0; --j) {
+    values.push_back(std::string(j, 'a') + "b");
+  }
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  MsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(MsdRadixSortTest, LongEqualStrings) {
+  std::vector<std::string> values(64, std::string(100000, 'x'));
+  values[10].back() = 'a';
+  values[20] += 'z';
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  MsdRadixSort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(ParallelLsdRadixSortTest, MatchesSequential) {
+  auto values = RandomVector<int64_t>(1 << 18);
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+
+  for (size_t threads : {1, 2, 3, 8}) {
+    auto copy = values;
+    ParallelLsdRadixSort(copy.begin(), copy.end(), threads);
+    ASSERT_EQ(copy, expected) << fmt::format("Wrong order with {} threads", threads);
+  }
+}
+
+TEST(ParallelLsdRadixSortTest, SmallInput) {
+  std::vector<uint32_t> values{3, 2, 1};
+  ParallelLsdRadixSort<16>(values.begin(), values.end(), 4);
+  ASSERT_EQ(values, (std::vector<uint32_t>{1, 2, 3}));
+}
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -1,89 +1,609 @@
 #pragma once
 
-#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
 #include <fmt/core.h>
 
+namespace detail::bst {
+
+// splitmix64: cheap, and a few bits of state per map instead of a whole std::mt19937
+inline uint64_t NextPriority(uint64_t& state) noexcept {
+  uint64_t z = (state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+// Priorities must not be predictable from the keys alone, or a crafted
+// insertion order makes the treap a path. Every map starts from its own
+// address mixed with a count of maps created so far
+inline uint64_t PrioritySeed(const void* map) noexcept {
+  static std::atomic<uint64_t> maps = 0;
+  uint64_t state = reinterpret_cast<uintptr_t>(map) ^ (maps.fetch_add(1, std::memory_order_relaxed) << 48);
+  return NextPriority(state);
+}
+
+// Nodes this close to the root aren't splayed: rotations cost more than
+// the few levels they save, and each lookup stays O(1) above the amortized bound
+inline constexpr size_t kSplayDepth = 8;
+
+// Priority field of a node in the modes without priorities
+struct NoPriority {
+};
+
+}  // namespace detail::bst
+
+// Balancing policies of Map
+
+// Random priorities: depth O(log n) expected for any input
+struct TreapBalancing {
+  static constexpr bool kHasPriorities = true;
+  static constexpr bool kSplays = false;
+};
+
+// Every accessed node deeper than detail::bst::kSplayDepth is rotated up
+// to the root: O(log n) amortized, and keys that are looked up often stay
+// near the root. Find changes the shape of the tree, so even const
+// lookups mustn't run concurrently
+struct SplayBalancing {
+  static constexpr bool kHasPriorities = false;
+  static constexpr bool kSplays = true;
+};
+
+// A plain BST: the depth depends on the order of insertions
+struct NoBalancing {
+  static constexpr bool kHasPriorities = false;
+  static constexpr bool kSplays = false;
+};
+
+// Instrumentation policies of Map
+
+// Counters of Map operations since construction or ResetStats()
+struct MapStats {
+  // Descents from the root: lookups, inserts, erasures, order statistics
+  size_t lookups = 0;
+  size_t comparisons = 0;
+  size_t node_visits = 0;
+  // The deepest node reached by a descent, the root has depth 1
+  size_t max_depth = 0;
+  size_t rotations = 0;
+  size_t allocations = 0;
+
+  double ComparisonsPerLookup() const noexcept {
+    return lookups == 0 ? 0 : static_cast<double>(comparisons) / lookups;
+  }
+
+  // Every descent visits one node per level
+  double AverageDepth() const noexcept {
+    return lookups == 0 ? 0 : static_cast<double>(node_visits) / lookups;
+  }
+};
+
+// Hooks compile to nothing, Stats() is always empty
+class NoInstrumentation {
+public:
+  inline void OnLookup() noexcept {
+  }
+
+  inline void OnVisit() noexcept {
+  }
+
+  inline void OnCompare() noexcept {
+  }
+
+  inline void OnRotation() noexcept {
+  }
+
+  inline void OnAllocate() noexcept {
+  }
+
+  inline MapStats Stats() const noexcept {
+    return {};
+  }
+
+  inline void Reset() noexcept {
+  }
+};
+
+// Counts everything. Not thread-safe, like Map itself: even const
+// lookups change the counters
+class CountingInstrumentation {
+public:
+  inline void OnLookup() noexcept {
+    ++stats_.lookups;
+    depth_ = 0;
+  }
+
+  inline void OnVisit() noexcept {
+    ++stats_.node_visits;
+    stats_.max_depth = std::max(stats_.max_depth, ++depth_);
+  }
+
+  inline void OnCompare() noexcept {
+    ++stats_.comparisons;
+  }
+
+  inline void OnRotation() noexcept {
+    ++stats_.rotations;
+  }
+
+  inline void OnAllocate() noexcept {
+    ++stats_.allocations;
+  }
+
+  inline MapStats Stats() const noexcept {
+    return stats_;
+  }
+
+  inline void Reset() noexcept {
+    stats_ = MapStats();
+  }
+
+private:
+  MapStats stats_;
+  // Depth of the current descent
+  size_t depth_ = 0;
+};
+
+// Ordered map on a treap: a binary search tree by keys and a heap by
+// random priorities at the same time. The shape of the tree is the one
+// of a BST with keys inserted in the order of priorities, that is, in
+// random order, so its depth is O(log n) expected for any input.
+//
+// Besides Insert / Erase / Find, a treap splits by a key and joins two
+// maps with ordered key ranges in O(log n) expected: ranges of keys can
+// be handed to workers without copying elements.
+//
+// Balancing replaces the treap with a splay tree (SplayBalancing) for
+// skewed access patterns, or with a plain BST (NoBalancing).
+// Instrumentation counts comparisons, depths and rotations: see
+// CountingInstrumentation and Stats().
 template <
   typename Key,
   typename Value,
-  typename Compare = std::less<Key>
+  typename Compare = std::less<Key>,
+  typename Balancing = TreapBalancing,
+  typename Instrumentation = NoInstrumentation
 >
 class Map {
 public:
-  Map() {
-    // Not implemented
+  Map() = default;
+
+  explicit Map(const Compare& comp) : comp_(comp) {
+  }
+
+  Map(const Map&) = delete;
+  Map& operator=(const Map&) = delete;
+
+  Map(Map&& other) noexcept {
+    Swap(other);
   }
 
-  Value& operator[](const Key& /*key*/) {
-    std::abort(); // Not implemented
+  Map& operator=(Map&& other) noexcept {
+    if (this != &other) {
+      Clear();
+      Swap(other);
+    }
+    return *this;
+  }
+
+  Value& operator[](const Key& key) {
+    Node* node = FindNode(key);
+    if (node == nullptr) {
+      return InsertNode(NewNode(key, Value()))->data_.second;
+    }
+    Splay();
+    return node->data_.second;
   }
 
   inline bool IsEmpty() const noexcept {
-    std::abort(); // Not implemented
+    return root_ == nullptr;
   }
 
   inline size_t Size() const noexcept {
-    std::abort(); // Not implemented
+    return SubtreeSize(root_);
   }
 
-  void Swap(Map& a) {
-    static_assert(std::is_same<decltype(this->comp), decltype(a.comp)>::value,
+  void Swap(Map& a) noexcept {
+    static_assert(std::is_same<decltype(this->comp_), decltype(a.comp_)>::value,
                   "The compare function types are different");
-    // Not implemented
+    std::swap(comp_, a.comp_);
+    std::swap(root_, a.root_);
+    std::swap(priority_state_, a.priority_state_);
+    std::swap(path_, a.path_);
+    std::swap(instrumentation_, a.instrumentation_);
+  }
+
+  std::vector<std::pair<const Key, Value>> Values(bool is_increase = true) const {
+    std::vector<std::pair<const Key, Value>> res;
+    res.reserve(Size());
+
+    // In-order walk with an explicit stack: from the smaller side first
+    std::vector<Node*> stack;
+    Node* node = root_;
+    while (node != nullptr || !stack.empty()) {
+      for (; node != nullptr; node = is_increase ? node->left_ : node->right_) {
+        stack.push_back(node);
+      }
+      node = stack.back();
+      stack.pop_back();
+      res.push_back(node->data_);
+      node = is_increase ? node->right_ : node->left_;
+    }
+
+    return res;
   }
 
-  std::vector<std::pair<const Key, Value>> Values(bool /*is_increase=true*/) const noexcept {
-    std::abort(); // Not implemented
+  // Inserts the pair or overwrites the value of an existing key
+  void Insert(const std::pair<const Key, Value>& val) {
+    Node* node = FindNode(val.first);
+    if (node != nullptr) {
+      node->data_.second = val.second;
+      Splay();
+      return;
+    }
+    InsertNode(NewNode(val.first, val.second));
   }
 
-  void Insert(const std::pair<const Key, Value>& /*val*/) {
-    // Not implemented
+  void Insert(const std::initializer_list<std::pair<const Key, Value>>& values) {
+    for (const auto& val : values) {
+      Insert(val);
+    }
   }
 
-  void Insert(const std::initializer_list<std::pair<const Key, Value>>& /*values*/){
-    // Not implemented
+  void Erase(const Key& key) {
+    instrumentation_.OnLookup();
+    Node** link = &root_;
+    while (*link != nullptr) {
+      Node* node = *link;
+      instrumentation_.OnVisit();
+      if (Less(key, node->data_.first)) {
+        --node->size_;
+        link = &node->left_;
+      } else if (Less(node->data_.first, key)) {
+        --node->size_;
+        link = &node->right_;
+      } else {
+        // Children of a node are already a treap: no rotations needed.
+        // A splay tree doesn't splay here, the parent isn't hotter than before
+        *link = JoinNodes(node->left_, node->right_);
+        delete node;
+        return;
+      }
+    }
+
+    // Sizes on the path were decreased in advance
+    for (Node* node = root_; node != nullptr;) {
+      ++node->size_;
+      node = Less(key, node->data_.first) ? node->left_ : node->right_;
+    }
+    throw std::runtime_error("Value not found");
   }
 
-  void Erase(const Key& /*key*/) {
-    // Not implemented
+  // Elements with keys not less than key move to the returned map
+  Map Split(const Key& key) {
+    Map greater(comp_);
+    instrumentation_.OnLookup();
+    SplitNode(root_, key, root_, greater.root_);
+    return greater;
   }
 
+  // Moves all elements of other to the end of this map: every key of
+  // other must be greater than every key here, otherwise
+  // std::invalid_argument is thrown and nothing changes
+  void Join(Map&& other) {
+    if (this == &other || other.IsEmpty()) {
+      return;
+    }
+    if (!IsEmpty() && !Less(Rightmost(root_)->data_.first, Leftmost(other.root_)->data_.first)) {
+      throw std::invalid_argument("Join requires greater keys in the other map");
+    }
+    root_ = JoinNodes(root_, other.root_);
+    other.root_ = nullptr;
+  }
+
+  // Rotations turn the left subtree into the right one until the root has
+  // no left child, then the root is deleted: O(n) without recursion and allocations
   void Clear() noexcept {
-    // Not implemented
+    while (root_ != nullptr) {
+      Node* node = root_;
+      if (node->left_ != nullptr) {
+        root_ = node->left_;
+        node->left_ = root_->right_;
+        root_->right_ = node;
+      } else {
+        root_ = node->right_;
+        delete node;
+      }
+    }
+  }
+
+  // Splays the found node or the last one on the way in SplayBalancing mode
+  bool Find(const Key& key) const {
+    Node* node = FindNode(key);
+    Splay();
+    return node != nullptr;
+  }
+
+  MapStats Stats() const noexcept {
+    return instrumentation_.Stats();
   }
 
-  bool Find(const Key& /*key*/) const {
-    std::abort(); // Not implemented
+  void ResetStats() noexcept {
+    instrumentation_.Reset();
   }
 
   ~Map() {
-    // Not implemented
+    Clear();
   }
 
 private:
   class Node {
     friend class Map;
 
+  public:
+    Node(const Key& key, const Value& value) : data_(key, value) {
+    }
 
-    private:
-      /*???*/
+  private:
+    std::pair<const Key, Value> data_;
+    [[no_unique_address]] std::conditional_t<Balancing::kHasPriorities, uint64_t, detail::bst::NoPriority> priority_{};
+    // Number of nodes in the subtree
+    size_t size_ = 1;
+    Node* left_ = nullptr;
+    Node* right_ = nullptr;
   };
-  /*???*/
 
-private:
-  Compare comp;
-  /*???*/
+  static inline size_t SubtreeSize(Node* node) noexcept {
+    return node == nullptr ? 0 : node->size_;
+  }
+
+  static inline void Update(Node* node) noexcept {
+    node->size_ = SubtreeSize(node->left_) + SubtreeSize(node->right_) + 1;
+  }
+
+  static Node* Leftmost(Node* node) noexcept {
+    while (node->left_ != nullptr) {
+      node = node->left_;
+    }
+    return node;
+  }
+
+  static Node* Rightmost(Node* node) noexcept {
+    while (node->right_ != nullptr) {
+      node = node->right_;
+    }
+    return node;
+  }
+
+  // All key comparisons and allocations go through Less and NewNode,
+  // Instrumentation counts them there
+
+  template <typename A, typename B>
+  inline bool Less(const A& lhs, const B& rhs) const {
+    instrumentation_.OnCompare();
+    return comp_(lhs, rhs);
+  }
 
+  inline Node* NewNode(const Key& key, const Value& value) {
+    Node* node = new Node(key, value);
+    instrumentation_.OnAllocate();
+    return node;
+  }
+
+  // In SplayBalancing mode the nodes on the way are left in path_
+  Node* FindNode(const Key& key) const {
+    if constexpr (Balancing::kSplays) {
+      path_.clear();
+    }
+    instrumentation_.OnLookup();
+    Node* node = root_;
+    while (node != nullptr) {
+      if constexpr (Balancing::kSplays) {
+        path_.push_back(node);
+      }
+      instrumentation_.OnVisit();
+      if (Less(key, node->data_.first)) {
+        node = node->left_;
+      } else if (Less(node->data_.first, key)) {
+        node = node->right_;
+      } else {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  // The key of node is absent. In a treap it goes down while priorities on
+  // the way are higher, and the subtree it stops at is split between its
+  // children. Without priorities it becomes a leaf
+  Node* InsertNode(Node* node) {
+    if constexpr (Balancing::kSplays) {
+      path_.clear();
+    }
+
+    instrumentation_.OnLookup();
+    Node** link = &root_;
+    if constexpr (Balancing::kHasPriorities) {
+      node->priority_ = detail::bst::NextPriority(priority_state_);
+      while (*link != nullptr && (*link)->priority_ > node->priority_) {
+        Node* parent = *link;
+        instrumentation_.OnVisit();
+        ++parent->size_;
+        link = Less(node->data_.first, parent->data_.first) ? &parent->left_ : &parent->right_;
+      }
+      SplitNode(*link, node->data_.first, node->left_, node->right_);
+      Update(node);
+    } else {
+      while (*link != nullptr) {
+        Node* parent = *link;
+        if constexpr (Balancing::kSplays) {
+          path_.push_back(parent);
+        }
+        instrumentation_.OnVisit();
+        ++parent->size_;
+        link = Less(node->data_.first, parent->data_.first) ? &parent->left_ : &parent->right_;
+      }
+      if constexpr (Balancing::kSplays) {
+        path_.push_back(node);
+      }
+    }
+
+    *link = node;
+    Splay();
+    return node;
+  }
+
+  // less gets keys less than key, rest gets the others. Without recursion:
+  // a splay tree or a plain BST may be as deep as the number of nodes
+  void SplitNode(Node* node, const Key& key, Node*& less, Node*& rest) const {
+    Node** less_link = &less;
+    Node** rest_link = &rest;
+    path_.clear();
+    while (node != nullptr) {
+      path_.push_back(node);
+      instrumentation_.OnVisit();
+      if (Less(node->data_.first, key)) {
+        *less_link = node;
+        less_link = &node->right_;
+        node = node->right_;
+      } else {
+        *rest_link = node;
+        rest_link = &node->left_;
+        node = node->left_;
+      }
+    }
+    *less_link = nullptr;
+    *rest_link = nullptr;
+
+    // Children are final now, sizes are fixed bottom-up
+    for (auto it = path_.rbegin(); it != path_.rend(); ++it) {
+      Update(*it);
+    }
+    path_.clear();
+  }
+
+  // All keys of left are less than the keys of right. The root with the
+  // higher priority stays the root, without priorities it is the root of
+  // right. A chosen root gets all nodes of the other tree to its subtree
+  static Node* JoinNodes(Node* left, Node* right) noexcept {
+    Node* root = nullptr;
+    Node** link = &root;
+    while (left != nullptr && right != nullptr) {
+      if (HasHigherPriority(left, right)) {
+        left->size_ += right->size_;
+        *link = left;
+        link = &left->right_;
+        left = left->right_;
+      } else {
+        right->size_ += left->size_;
+        *link = right;
+        link = &right->left_;
+        right = right->left_;
+      }
+    }
+    *link = left != nullptr ? left : right;
+    return root;
+  }
+
+  static inline bool HasHigherPriority(Node* a, Node* b) noexcept {
+    if constexpr (Balancing::kHasPriorities) {
+      return a->priority_ > b->priority_;
+    } else {
+      return false;
+    }
+  }
+
+  void RotateUp(Node** link, Node* child) const noexcept {
+    instrumentation_.OnRotation();
+    Node* parent = *link;
+    if (parent->left_ == child) {
+      parent->left_ = child->right_;
+      child->right_ = parent;
+    } else {
+      parent->right_ = child->left_;
+      child->left_ = parent;
+    }
+    Update(parent);
+    Update(child);
+    *link = child;
+  }
+
+  // Link to path_[i] from its parent, path_[i - 1]
+  Node** LinkTo(size_t i) const noexcept {
+    if (i == 0) {
+      return &root_;
+    }
+    Node* parent = path_[i - 1];
+    return parent->left_ == path_[i] ? &parent->left_ : &parent->right_;
+  }
+
+  // Bottom-up splay of the last node of path_ to the root, unless it is
+  // shallow. Zig-zig rotates the parent first, so the path to the node is
+  // folded roughly in half
+  void Splay() const noexcept {
+    if constexpr (Balancing::kSplays) {
+      if (path_.size() <= detail::bst::kSplayDepth) {
+        path_.clear();
+        return;
+      }
+
+      size_t i = path_.size() - 1;
+      Node* node = path_[i];
+      // Entries below i are untouched ancestors, node takes the place of path_[i]
+      for (; i >= 2; i -= 2) {
+        Node* parent = path_[i - 1];
+        Node* grand = path_[i - 2];
+        Node** link = LinkTo(i - 2);
+        if ((grand->left_ == parent) == (parent->left_ == node)) {
+          RotateUp(link, parent);
+        } else {
+          RotateUp(grand->left_ == parent ? &grand->left_ : &grand->right_, node);
+        }
+        RotateUp(link, node);
+      }
+      if (i == 1) {
+        RotateUp(&root_, node);
+      }
+      path_.clear();
+    }
+  }
+
+private:
+  Compare comp_;
+  // Lookups of a splay tree rotate nodes
+  mutable Node* root_ = nullptr;
+  uint64_t priority_state_ = detail::bst::PrioritySeed(this);
+  // Nodes on the way down: for splaying and for fixing sizes after a split
+  mutable std::vector<Node*> path_;
+  // Hooks are called from const lookups too
+  [[no_unique_address]] mutable Instrumentation instrumentation_;
 };
 
-namespace std{
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using SplayMap = Map<Key, Value, Compare, SplayBalancing>;
+
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using UnbalancedMap = Map<Key, Value, Compare, NoBalancing>;
+
+// Map that counts its work, see Stats()
+template <typename Key, typename Value, typename Compare = std::less<Key>, typename Balancing = TreapBalancing>
+using InstrumentedMap = Map<Key, Value, Compare, Balancing, CountingInstrumentation>;
+
+namespace std {
 // Global swap overloading
-  template <typename Key, typename Value>
-  void swap(Map<Key, Value>& a, Map<Key, Value>& b) {
-    a.Swap(b);
-  }
-}
\ No newline at end of file
+template <typename Key, typename Value, typename Compare, typename Balancing, typename Instrumentation>
+// NOLINTNEXTLINE
+void swap(Map<Key, Value, Compare, Balancing, Instrumentation>& a, Map<Key, Value, Compare, Balancing, Instrumentation>& b) {
+  a.Swap(b);
+}
+}  // namespace std
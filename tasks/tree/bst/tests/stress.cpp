@@ -1,13 +1,17 @@
+#include <algorithm>
+#include <numeric>
 #include <random>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 #include <fmt/core.h>
 
 #include "../map.hpp"
 
-void ConstructRandomMap(Map<int, int>& mp, int sz) {
+template <typename MapType>
+void ConstructRandomMap(MapType& mp, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -31,7 +35,8 @@ void ConstructRandomMap(std::map<int, int>& mp, int sz) {
   }
 }
 
-void ConstructLinearMap(Map<int, int>& mp, int sz) {
+template <typename MapType>
+void ConstructLinearMap(MapType& mp, int sz) {
   while(sz) {
     mp.Insert(std::pair{sz, 1});
     --sz;
@@ -132,6 +137,155 @@ void BM_StdMapClear(benchmark::State& state) {
   state.SetComplexityN(state.range(0));
 }
 
+// Keys not less than a random bound go to another map and back
+void BM_CustomMapSplitJoin(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  std::mt19937 mt(42);
+  for (auto _ : state) {
+    auto greater = mp.Split(static_cast<int>(mt()));
+    mp.Join(std::move(greater));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// The same without Split and Join: the elements are moved one by one
+void BM_CustomMapSplitJoinByCopy(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  std::mt19937 mt(42);
+  for (auto _ : state) {
+    int bound = static_cast<int>(mt());
+    Map<int, int> greater;
+    for (const auto& val: mp.Values(true)) {
+      if (val.first >= bound) {
+        greater.Insert(val);
+        mp.Erase(val.first);
+      }
+    }
+    for (const auto& val: greater.Values(true)) {
+      mp.Insert(val);
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Lookups by Zipf's law with s = 1: the key of rank r is requested with
+// probability proportional to 1 / r, so a few hundred keys get most of them.
+// Ranks are given to the keys 0..sz-1 in random order
+std::vector<int> ZipfKeys(int sz, size_t count) {
+  std::mt19937 mt(42);
+  std::vector<int> keys(sz);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), mt);
+
+  std::vector<double> cdf(sz);
+  double sum = 0;
+  for (int rank = 0; rank < sz; ++rank) {
+    sum += 1.0 / (rank + 1);
+    cdf[rank] = sum;
+  }
+
+  std::uniform_real_distribution<double> dist(0, sum);
+  std::vector<int> lookups(count);
+  for (auto& key: lookups) {
+    auto rank = std::upper_bound(cdf.begin(), cdf.end(), dist(mt)) - cdf.begin();
+    key = keys[std::min<ptrdiff_t>(rank, sz - 1)];
+  }
+  return lookups;
+}
+
+// Keys 0..sz-1 inserted in random order: an unbalanced tree is not a list either
+std::vector<int> ShuffledKeys(int sz) {
+  std::mt19937 mt(7);
+  std::vector<int> keys(sz);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), mt);
+  return keys;
+}
+
+template <typename Balancing>
+void BM_CustomMapZipfFind(benchmark::State& state) {
+  Map<int, int, std::less<int>, Balancing> mp;
+  for (int key: ShuffledKeys(state.range(0))) {
+    mp[key] = key;
+  }
+  auto lookups = ZipfKeys(state.range(0), 1 << 16);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.Find(lookups[i]));
+    i = (i + 1) % lookups.size();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void ReportStats(benchmark::State& state, const MapStats& stats) {
+  state.counters["comparisons_per_lookup"] = stats.ComparisonsPerLookup();
+  state.counters["average_depth"] = stats.AverageDepth();
+  state.counters["max_depth"] = static_cast<double>(stats.max_depth);
+  state.counters["rotations_per_lookup"] = static_cast<double>(stats.rotations) / stats.lookups;
+  state.counters["allocations_per_lookup"] = static_cast<double>(stats.allocations) / stats.lookups;
+}
+
+template <typename Balancing>
+void BM_InstrumentedMapRandomInsert(benchmark::State& state) {
+  MapStats stats;
+  for (auto _ : state) {
+    InstrumentedMap<int, int, std::less<int>, Balancing> mp;
+    ConstructRandomMap(mp, state.range(0));
+    stats = mp.Stats();
+  }
+  ReportStats(state, stats);
+  state.SetComplexityN(state.range(0));
+}
+
+template <typename Balancing>
+void BM_InstrumentedMapLinearInsert(benchmark::State& state) {
+  MapStats stats;
+  for (auto _ : state) {
+    InstrumentedMap<int, int, std::less<int>, Balancing> mp;
+    ConstructLinearMap(mp, state.range(0));
+    stats = mp.Stats();
+  }
+  ReportStats(state, stats);
+  state.SetComplexityN(state.range(0));
+}
+
+// Depths and rotations behind BM_CustomMapZipfFind
+template <typename Balancing>
+void BM_InstrumentedMapZipfFind(benchmark::State& state) {
+  InstrumentedMap<int, int, std::less<int>, Balancing> mp;
+  for (int key: ShuffledKeys(state.range(0))) {
+    mp[key] = key;
+  }
+  auto lookups = ZipfKeys(state.range(0), 1 << 16);
+  mp.ResetStats();
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.Find(lookups[i]));
+    i = (i + 1) % lookups.size();
+  }
+  ReportStats(state, mp.Stats());
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdMapZipfFind(benchmark::State& state) {
+  std::map<int, int> mp;
+  for (int key: ShuffledKeys(state.range(0))) {
+    mp[key] = key;
+  }
+  auto lookups = ZipfKeys(state.range(0), 1 << 16);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.find(lookups[i]));
+    i = (i + 1) % lookups.size();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
 
 BENCHMARK(BM_CustomMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StdMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
@@ -139,7 +293,21 @@ BENCHMARK(BM_CustomMapLinearInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(ben
 BENCHMARK(BM_StdMapLinearInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_CustomMapErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StdMapErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSplitJoin)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_CustomMapSplitJoinByCopy)->Range(1<<10, 1<<17)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_CustomMapClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StdMapClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapZipfFind, TreapBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(BM_CustomMapZipfFind, SplayBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(BM_CustomMapZipfFind, NoBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_StdMapZipfFind)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapRandomInsert, TreapBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapRandomInsert, SplayBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapLinearInsert, TreapBalancing)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapLinearInsert, SplayBalancing)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapLinearInsert, NoBalancing)->Range(1<<10, 1<<12)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapZipfFind, TreapBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapZipfFind, SplayBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(BM_InstrumentedMapZipfFind, NoBalancing)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kNanosecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
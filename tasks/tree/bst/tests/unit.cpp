@@ -1,9 +1,14 @@
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cmath>
 #include <future>
 #include <map>
 #include <iostream>
+#include <random>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <fmt/core.h>
 #include <gtest/gtest.h>
@@ -291,6 +296,7 @@ TEST_F(MapTest, EraseNotExistingValue) {
   EXPECT_ANY_THROW({
     mp.Erase(-100);
   });
+}
 
 TEST_F(MapTest, CustomComparator) {
   struct Point {
@@ -335,6 +341,242 @@ TEST_F(MapTest, CustomComparator) {
 }
 
 
+template <typename Key, typename Value, typename Compare, typename Balancing>
+void ExpectSameContent(const Map<Key, Value, Compare, Balancing>& mp, const std::map<Key, Value, Compare>& expected) {
+  ASSERT_EQ(mp.Size(), expected.size());
+  auto values = mp.Values(true);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+  values = mp.Values(false);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.rbegin(), expected.rend()));
+}
+
+template <typename Balancing>
+void CheckRandomOperations() {
+  std::mt19937 mt(42);
+  Map<int, int, std::less<int>, Balancing> mp;
+  std::map<int, int> expected;
+
+  for (int i = 0; i < 20000; ++i) {
+    int key = static_cast<int>(mt() % 2000);
+    switch (mt() % 4) {
+      case 0:
+        if (expected.erase(key) == 0) {
+          ASSERT_ANY_THROW(mp.Erase(key));
+        } else {
+          mp.Erase(key);
+        }
+        break;
+      case 1:
+        ASSERT_EQ(mp.Find(key), expected.contains(key));
+        break;
+      default:
+        mp.Insert({key, i});
+        expected[key] = i;
+    }
+    ASSERT_EQ(mp.Size(), expected.size());
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST(TreapTest, RandomOperations) {
+  CheckRandomOperations<TreapBalancing>();
+}
+
+TEST(SplayTest, RandomOperations) {
+  CheckRandomOperations<SplayBalancing>();
+}
+
+TEST(UnbalancedTest, RandomOperations) {
+  CheckRandomOperations<NoBalancing>();
+}
+
+// A sorted input doesn't turn the treap into a list: 10^6 sorted
+// inserts take seconds on a ladder, here they are almost instant
+TEST(TreapTest, SortedInsert) {
+  Map<int, int> mp;
+  for (int i = 0; i < 1000000; ++i) {
+    mp[i] = i;
+  }
+  ASSERT_EQ(mp.Size(), 1000000);
+  ASSERT_TRUE(mp.Find(999999));
+  mp.Clear();
+  ASSERT_TRUE(mp.IsEmpty());
+}
+
+// Maps created one after another at the same address get different
+// priorities: the same keys give trees of different shapes
+TEST(TreapTest, PrioritiesPerMap) {
+  std::vector<size_t> depths;
+  for (int i = 0; i < 10; ++i) {
+    InstrumentedMap<int, int> mp;
+    for (int key = 0; key < 1000; ++key) {
+      mp[key] = key;
+    }
+    mp.ResetStats();
+    for (int key = 0; key < 1000; ++key) {
+      mp.Find(key);
+    }
+    depths.push_back(mp.Stats().node_visits);
+  }
+  std::sort(depths.begin(), depths.end());
+  ASSERT_NE(depths.front(), depths.back());
+}
+
+TEST(SplitJoinTest, Split) {
+  std::mt19937 mt(7);
+  for (int split_key: {-1, 0, 500, 777, 1000, 2000}) {
+    Map<int, int> mp;
+    std::map<int, int> less;
+    std::map<int, int> rest;
+    for (int i = 0; i < 1000; ++i) {
+      int key = static_cast<int>(mt() % 1000);
+      mp[key] = key;
+      (key < split_key ? less : rest)[key] = key;
+    }
+
+    auto greater = mp.Split(split_key);
+    ExpectSameContent(mp, less);
+    ExpectSameContent(greater, rest);
+
+    // Both halves stay ordinary maps
+    greater.Insert({split_key, 1});
+    rest[split_key] = 1;
+    ExpectSameContent(greater, rest);
+  }
+
+  Map<int, int> empty;
+  ASSERT_TRUE(empty.Split(0).IsEmpty());
+}
+
+TEST(SplitJoinTest, JoinRestoresSplit) {
+  Map<std::string, int> mp;
+  std::map<std::string, int> expected;
+  for (int i = 0; i < 500; ++i) {
+    auto key = fmt::format("key-{:04}", i * 7 % 500);
+    mp[key] = i;
+    expected[key] = i;
+  }
+
+  // Shards of key ranges are split off and joined back in order
+  std::vector<Map<std::string, int>> shards;
+  for (const char* bound: {"key-0400", "key-0300", "key-0200", "key-0100"}) {
+    shards.push_back(mp.Split(bound));
+  }
+  ASSERT_EQ(mp.Size(), 100);
+  for (auto it = shards.rbegin(); it != shards.rend(); ++it) {
+    ASSERT_EQ(it->Size(), 100);
+    mp.Join(std::move(*it));
+    ASSERT_TRUE(it->IsEmpty());
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST(SplitJoinTest, JoinWrongRanges) {
+  Map<int, int> mp;
+  Map<int, int> other;
+  mp.Insert({{1, 1}, {5, 5}});
+  other.Insert({{5, 0}, {6, 6}});
+
+  ASSERT_THROW(mp.Join(std::move(other)), std::invalid_argument);
+  ASSERT_EQ(mp.Size(), 2);
+  ASSERT_EQ(other.Size(), 2);
+
+  other.Erase(5);
+  mp.Join(std::move(other));
+  ASSERT_EQ(mp.Size(), 3);
+
+  Map<int, int> empty;
+  empty.Join(std::move(mp));
+  ASSERT_EQ(empty.Size(), 3);
+  ASSERT_TRUE(mp.IsEmpty());
+}
+
+// Sorted inserts leave a splay tree as a path of 10^6 nodes: lookups,
+// splits and joins on it must not run out of stack
+TEST(SplayTest, DeepTree) {
+  SplayMap<int, int> mp;
+  for (int i = 0; i < 1000000; ++i) {
+    mp[i] = i;
+  }
+  ASSERT_TRUE(mp.Find(0));
+  ASSERT_FALSE(mp.Find(-1));
+
+  auto greater = mp.Split(500000);
+  ASSERT_EQ(mp.Size(), 500000);
+  ASSERT_EQ(greater.Size(), 500000);
+  ASSERT_EQ(greater[999999], 999999);
+  mp.Join(std::move(greater));
+  ASSERT_EQ(mp.Size(), 1000000);
+
+  for (int i = 0; i < 1000000; i += 1000) {
+    ASSERT_EQ(mp[i], i);
+  }
+  mp.Erase(0);
+  ASSERT_FALSE(mp.Find(0));
+  ASSERT_EQ(mp.Size(), 999999);
+}
+
+// Lookups in a const map splay too, the content stays the same
+TEST(SplayTest, ConstFind) {
+  SplayMap<std::string, int> mp;
+  std::map<std::string, int> expected;
+  for (int i = 0; i < 100; ++i) {
+    auto key = fmt::format("key-{}", i);
+    mp[key] = i;
+    expected[key] = i;
+  }
+
+  const auto& const_mp = mp;
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_EQ(const_mp.Find(fmt::format("key-{}", i * 37 % 150)), i * 37 % 150 < 100);
+  }
+  ExpectSameContent(mp, expected);
+}
+
+// Sorted inserts into a plain BST make a path: every counter is exact
+TEST(InstrumentationTest, CountsLookups) {
+  InstrumentedMap<int, int, std::less<int>, NoBalancing> mp;
+  for (int i = 0; i < 100; ++i) {
+    mp[i] = i;
+  }
+  ASSERT_EQ(mp.Stats().allocations, 100);
+  ASSERT_EQ(mp.Stats().max_depth, 99);
+  ASSERT_EQ(mp.Stats().rotations, 0);
+
+  mp.ResetStats();
+  ASSERT_TRUE(mp.Find(99));
+  auto stats = mp.Stats();
+  ASSERT_EQ(stats.lookups, 1);
+  ASSERT_EQ(stats.node_visits, 100);
+  ASSERT_EQ(stats.max_depth, 100);
+  // Two comparisons a level: the key is greater than every node but the last
+  ASSERT_EQ(stats.comparisons, 200);
+  ASSERT_EQ(stats.AverageDepth(), 100);
+  ASSERT_EQ(stats.allocations, 0);
+
+  mp.ResetStats();
+  ASSERT_EQ(mp.Stats().lookups, 0);
+  ASSERT_EQ(mp.Stats().ComparisonsPerLookup(), 0);
+}
+
+// A deep key found once is rotated to the root and found at once afterwards
+TEST(InstrumentationTest, CountsSplayRotations) {
+  InstrumentedMap<int, int, std::less<int>, SplayBalancing> mp;
+  for (int i = 0; i < 100; ++i) {
+    mp[i] = i;
+  }
+
+  mp.ResetStats();
+  ASSERT_TRUE(mp.Find(0));
+  ASSERT_GT(mp.Stats().max_depth, detail::bst::kSplayDepth);
+  ASSERT_EQ(mp.Stats().rotations, mp.Stats().node_visits - 1);
+
+  mp.ResetStats();
+  ASSERT_TRUE(mp.Find(0));
+  ASSERT_EQ(mp.Stats().node_visits, 1);
+  ASSERT_EQ(mp.Stats().rotations, 0);
+}
+
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,604 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace detail::btree {
+
+inline constexpr size_t RoundUp(size_t bytes, size_t alignment) noexcept {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+// Capacity of a node: the largest one whose node fits into `budget`.
+// `node_bytes(slots)` is the whole size of a node with that capacity:
+// the header, the slots and one spare slot for the element that overflows
+// the node. At least 4: halves of a split node must not be below the minimal fill
+template <typename NodeSize>
+constexpr size_t SlotCount(size_t budget, NodeSize node_bytes) noexcept {
+    size_t slots = 4;
+    while (node_bytes(slots + 1) <= budget) {
+        ++slots;
+    }
+    return slots;
+}
+
+}  // namespace detail::btree
+
+// Ordered map on a B+ tree with the interface of Map from tree/iterators.
+//
+// A node holds many keys in one contiguous array sized to NodeBytes,
+// so a lookup costs one cache miss per level of a tree of height log_B(n)
+// instead of one per level of a binary tree. Inner nodes keep only keys
+// and children, elements live in leaves chained left to right for iteration.
+//
+// Unlike Map, elements move between nodes on splits and merges:
+// Insert and Erase invalidate iterators and references.
+// Key must be default constructible: inner nodes keep arrays of keys.
+template <typename Key, typename Value, typename Compare = std::less<Key>, size_t NodeBytes = 256>
+class BTreeMap {
+    struct Node;
+    struct Leaf;
+    struct Inner;
+
+public:
+    class MapIterator {
+        friend class BTreeMap;
+
+    public:
+        // NOLINTNEXTLINE
+        using value_type = std::pair<const Key, Value>;
+        // NOLINTNEXTLINE
+        using reference_type = value_type&;
+        // NOLINTNEXTLINE
+        using pointer_type = value_type*;
+        // NOLINTNEXTLINE
+        using difference_type = std::ptrdiff_t;
+        // NOLINTNEXTLINE
+        using iterator_category = std::forward_iterator_tag;
+
+        inline bool operator==(const MapIterator& other) const {
+            return leaf_ == other.leaf_ && index_ == other.index_;
+        }
+
+        inline bool operator!=(const MapIterator& other) const {
+            return !(*this == other);
+        }
+
+        inline reference_type operator*() const {
+            return *leaf_->Slot(index_);
+        }
+
+        inline pointer_type operator->() const {
+            return leaf_->Slot(index_);
+        }
+
+        MapIterator& operator++() {
+            if (++index_ == leaf_->size) {
+                leaf_ = leaf_->next;
+                index_ = 0;
+            }
+            return *this;
+        }
+
+        MapIterator operator++(int) {
+            MapIterator copy = *this;
+            operator++();
+            return copy;
+        }
+
+    private:
+        MapIterator(Leaf* leaf, size_t index) : leaf_(leaf), index_(index) {
+        }
+
+    private:
+        // nullptr for End()
+        Leaf* leaf_;
+        size_t index_;
+    };
+
+    BTreeMap() = default;
+
+    BTreeMap(const BTreeMap&) = delete;
+    BTreeMap& operator=(const BTreeMap&) = delete;
+
+    BTreeMap(BTreeMap&& other) noexcept {
+        Swap(other);
+    }
+
+    BTreeMap& operator=(BTreeMap&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    inline MapIterator Begin() const noexcept {
+        if (IsEmpty()) {
+            return End();
+        }
+
+        Node* node = root_;
+        while (!node->is_leaf) {
+            node = static_cast<Inner*>(node)->children[0];
+        }
+        return MapIterator(static_cast<Leaf*>(node), 0);
+    }
+
+    inline MapIterator End() const noexcept {
+        return MapIterator(nullptr, 0);
+    }
+
+    Value& operator[](const Key& key) {
+        return InsertNode(key).first->second;
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return sz_ == 0;
+    }
+
+    inline size_t Size() const noexcept {
+        return sz_;
+    }
+
+    void Swap(BTreeMap& a) noexcept {
+        std::swap(comp_, a.comp_);
+        std::swap(root_, a.root_);
+        std::swap(sz_, a.sz_);
+    }
+
+    std::vector<std::pair<const Key, Value>> Values(bool is_increase = true) const {
+        std::vector<std::pair<const Key, Value>> res;
+        res.reserve(sz_);
+
+        for (auto it = Begin(); it != End(); ++it) {
+            res.push_back(*it);
+        }
+
+        // Leaves are chained only forward
+        if (!is_increase) {
+            std::vector<std::pair<const Key, Value>> reversed(res.rbegin(), res.rend());
+            return reversed;
+        }
+        return res;
+    }
+
+    void Insert(const std::pair<const Key, Value>& val) {
+        auto [it, is_inserted] = InsertNode(val.first, val.second);
+        if (!is_inserted) {
+            it->second = val.second;
+        }
+    }
+
+    void Insert(const std::initializer_list<std::pair<const Key, Value>>& values) {
+        for (const auto& val : values) {
+            Insert(val);
+        }
+    }
+
+    void Erase(const Key& key) {
+        if (IsEmpty() || !EraseFrom(root_, key)) {
+            throw std::runtime_error("Value not found");
+        }
+        --sz_;
+
+        // The root may have less elements than other nodes, but an inner root
+        // with a single child is dropped: the tree gets lower
+        if (root_->is_leaf) {
+            if (root_->size == 0) {
+                delete static_cast<Leaf*>(root_);
+                root_ = nullptr;
+            }
+        } else if (root_->size == 0) {
+            Inner* old_root = static_cast<Inner*>(root_);
+            root_ = old_root->children[0];
+            delete old_root;
+        }
+    }
+
+    void Clear() noexcept {
+        if (root_ != nullptr) {
+            Destroy(root_);
+        }
+        root_ = nullptr;
+        sz_ = 0;
+    }
+
+    MapIterator Find(const Key& key) const {
+        if (IsEmpty()) {
+            return End();
+        }
+
+        Node* node = root_;
+        while (!node->is_leaf) {
+            Inner* inner = static_cast<Inner*>(node);
+            node = inner->children[ChildIndex(inner, key)];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(node);
+        size_t pos = LowerIndex(leaf, key);
+        if (pos < leaf->size && !comp_(key, leaf->Slot(pos)->first)) {
+            return MapIterator(leaf, pos);
+        }
+        return End();
+    }
+
+    ~BTreeMap() {
+        Clear();
+    }
+
+private:
+    using Pair = std::pair<const Key, Value>;
+
+    struct Node {
+        uint16_t size = 0;
+        bool is_leaf;
+
+        explicit Node(bool leaf) : is_leaf(leaf) {
+        }
+    };
+
+    // Sizes of Leaf and Inner below with the given capacity,
+    // field by field with the padding between them
+    static constexpr auto kLeafBytes = [](size_t slots) noexcept {
+        using detail::btree::RoundUp;
+        size_t storage = RoundUp(RoundUp(sizeof(Node), alignof(Node*)) + sizeof(Node*), alignof(Pair));
+        return RoundUp(storage + sizeof(Pair) * (slots + 1), std::max({alignof(Node), alignof(Node*), alignof(Pair)}));
+    };
+
+    static constexpr auto kInnerBytes = [](size_t slots) noexcept {
+        using detail::btree::RoundUp;
+        size_t keys = RoundUp(sizeof(Node), alignof(Key));
+        size_t children = RoundUp(keys + sizeof(Key) * (slots + 1), alignof(Node*));
+        return RoundUp(children + sizeof(Node*) * (slots + 2), std::max({alignof(Node), alignof(Node*), alignof(Key)}));
+    };
+
+    static constexpr size_t kLeafSlots = detail::btree::SlotCount(NodeBytes, kLeafBytes);
+    static constexpr size_t kInnerSlots = detail::btree::SlotCount(NodeBytes, kInnerBytes);
+
+    // Every node except the root holds at least half of its capacity
+    static constexpr size_t kMinLeaf = kLeafSlots / 2;
+    static constexpr size_t kMinInner = kInnerSlots / 2;
+
+    // Elements are constructed in place in raw storage:
+    // the key is const, so slots are shifted by move-construction
+    struct Leaf : Node {
+        Leaf* next = nullptr;
+        alignas(Pair) std::byte storage[sizeof(Pair) * (kLeafSlots + 1)];
+
+        Leaf() : Node(true) {
+        }
+
+        inline Pair* Slot(size_t index) noexcept {
+            return std::launder(reinterpret_cast<Pair*>(storage) + index);
+        }
+    };
+
+    // keys[i] separates children[i] and children[i + 1]:
+    // every key of children[i] is less than keys[i], every key of children[i + 1] is not
+    struct Inner : Node {
+        Key keys[kInnerSlots + 1];
+        Node* children[kInnerSlots + 2];
+
+        Inner() : Node(false) {
+        }
+    };
+
+    static_assert(kLeafSlots <= UINT16_MAX && kInnerSlots <= UINT16_MAX, "Node size doesn't fit into uint16_t");
+    static_assert(sizeof(Leaf) == kLeafBytes(kLeafSlots) && sizeof(Inner) == kInnerBytes(kInnerSlots),
+                  "Node layout differs from the one capacities are computed for");
+
+    // Index of the child that may contain key. Linear scan: the keys are
+    // contiguous, so the whole node is a few cache lines read sequentially
+    size_t ChildIndex(const Inner* inner, const Key& key) const {
+        size_t i = 0;
+        while (i < inner->size && !comp_(key, inner->keys[i])) {
+            ++i;
+        }
+        return i;
+    }
+
+    // Index of the first element that is not less than key
+    size_t LowerIndex(Leaf* leaf, const Key& key) const {
+        size_t i = 0;
+        while (i < leaf->size && comp_(leaf->Slot(i)->first, key)) {
+            ++i;
+        }
+        return i;
+    }
+
+    static void MoveSlot(Leaf* from, size_t i, Leaf* to, size_t j) {
+        new (reinterpret_cast<Pair*>(to->storage) + j) Pair(std::move(*from->Slot(i)));
+        from->Slot(i)->~Pair();
+    }
+
+    // Moves slots [first, from->size) of `from` to the end of `to`
+    static void MoveTail(Leaf* from, size_t first, Leaf* to) {
+        for (size_t i = first; i < from->size; ++i) {
+            MoveSlot(from, i, to, to->size++);
+        }
+        from->size = first;
+    }
+
+    static void ShiftRight(Leaf* leaf, size_t pos) {
+        for (size_t i = leaf->size; i > pos; --i) {
+            MoveSlot(leaf, i - 1, leaf, i);
+        }
+    }
+
+    static void ShiftLeft(Leaf* leaf, size_t pos) {
+        for (size_t i = pos; i + 1 < leaf->size; ++i) {
+            MoveSlot(leaf, i + 1, leaf, i);
+        }
+    }
+
+    // Smallest key of the subtree: a valid separator in front of it
+    static const Key& LeftmostKey(Node* node) {
+        while (!node->is_leaf) {
+            node = static_cast<Inner*>(node)->children[0];
+        }
+        return static_cast<Leaf*>(node)->Slot(0)->first;
+    }
+
+    // Returns the element with an equivalent key and whether it was just created
+    template <typename... Args>
+    std::pair<Pair*, bool> InsertNode(const Key& key, Args&&... args) {
+        if (root_ == nullptr) {
+            root_ = new Leaf();
+        }
+
+        Pair* result = nullptr;
+        bool is_inserted = false;
+
+        Node* right = InsertInto(root_, key, result, is_inserted, std::forward<Args>(args)...);
+        if (right != nullptr) {
+            // The root has split: the tree grows by one level at the top
+            Inner* root = new Inner();
+            root->size = 1;
+            root->keys[0] = LeftmostKey(right);
+            root->children[0] = root_;
+            root->children[1] = right;
+            root_ = root;
+        }
+
+        if (is_inserted) {
+            ++sz_;
+        }
+        return {result, is_inserted};
+    }
+
+    // Inserts into the subtree of node. If node overflows, it is split
+    // and the new right sibling is returned for the parent to link
+    template <typename... Args>
+    Node* InsertInto(Node* node, const Key& key, Pair*& result, bool& is_inserted, Args&&... args) {
+        if (node->is_leaf) {
+            return InsertIntoLeaf(static_cast<Leaf*>(node), key, result, is_inserted, std::forward<Args>(args)...);
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        size_t index = ChildIndex(inner, key);
+
+        Node* child_right = InsertInto(inner->children[index], key, result, is_inserted, std::forward<Args>(args)...);
+        if (child_right == nullptr) {
+            return nullptr;
+        }
+
+        // Nodes have one spare slot: the overflowing node is split evenly.
+        // The middle key is dropped: the separator in the parent is
+        // the leftmost key of the right half, found by LeftmostKey
+        InsertChild(inner, index, child_right);
+        if (inner->size <= kInnerSlots) {
+            return nullptr;
+        }
+
+        size_t mid = inner->size / 2;
+        Inner* right = new Inner();
+        right->size = inner->size - mid - 1;
+        std::move(inner->keys + mid + 1, inner->keys + inner->size, right->keys);
+        std::copy(inner->children + mid + 1, inner->children + inner->size + 1, right->children);
+        inner->size = mid;
+        return right;
+    }
+
+    // Links child as the right neighbour of children[index]
+    static void InsertChild(Inner* inner, size_t index, Node* child) {
+        std::move_backward(inner->keys + index, inner->keys + inner->size, inner->keys + inner->size + 1);
+        std::copy_backward(inner->children + index + 1, inner->children + inner->size + 1,
+                           inner->children + inner->size + 2);
+        inner->keys[index] = LeftmostKey(child);
+        inner->children[index + 1] = child;
+        ++inner->size;
+    }
+
+    template <typename... Args>
+    Node* InsertIntoLeaf(Leaf* leaf, const Key& key, Pair*& result, bool& is_inserted, Args&&... args) {
+        size_t pos = LowerIndex(leaf, key);
+        if (pos < leaf->size && !comp_(key, leaf->Slot(pos)->first)) {
+            result = leaf->Slot(pos);
+            return nullptr;
+        }
+
+        Pair value(key, Value(std::forward<Args>(args)...));
+        ShiftRight(leaf, pos);
+        new (reinterpret_cast<Pair*>(leaf->storage) + pos) Pair(std::move(value));
+        ++leaf->size;
+        is_inserted = true;
+
+        if (leaf->size <= kLeafSlots) {
+            result = leaf->Slot(pos);
+            return nullptr;
+        }
+
+        size_t mid = leaf->size / 2;
+        Leaf* right = new Leaf();
+        MoveTail(leaf, mid, right);
+        right->next = leaf->next;
+        leaf->next = right;
+
+        result = (pos < mid) ? leaf->Slot(pos) : right->Slot(pos - mid);
+        return right;
+    }
+
+    // Returns whether the key was found. Children that fall below the minimal
+    // fill borrow an element from a sibling or are merged with it
+    bool EraseFrom(Node* node, const Key& key) {
+        if (node->is_leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            size_t pos = LowerIndex(leaf, key);
+            if (pos == leaf->size || comp_(key, leaf->Slot(pos)->first)) {
+                return false;
+            }
+
+            leaf->Slot(pos)->~Pair();
+            for (size_t i = pos; i + 1 < leaf->size; ++i) {
+                MoveSlot(leaf, i + 1, leaf, i);
+            }
+            --leaf->size;
+            return true;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        size_t index = ChildIndex(inner, key);
+        if (!EraseFrom(inner->children[index], key)) {
+            return false;
+        }
+
+        Node* child = inner->children[index];
+        if (child->size < (child->is_leaf ? kMinLeaf : kMinInner)) {
+            FixUnderflow(inner, index);
+        }
+        return true;
+    }
+
+    void FixUnderflow(Inner* parent, size_t index) {
+        Node* child = parent->children[index];
+        size_t min_size = child->is_leaf ? kMinLeaf : kMinInner;
+
+        if (index > 0 && parent->children[index - 1]->size > min_size) {
+            BorrowFromLeft(parent, index);
+        } else if (index < parent->size && parent->children[index + 1]->size > min_size) {
+            BorrowFromRight(parent, index);
+        } else if (index > 0) {
+            Merge(parent, index - 1);
+        } else {
+            Merge(parent, index);
+        }
+    }
+
+    static void BorrowFromLeft(Inner* parent, size_t index) {
+        Node* child = parent->children[index];
+        Node* left = parent->children[index - 1];
+
+        if (child->is_leaf) {
+            Leaf* leaf = static_cast<Leaf*>(child);
+            Leaf* from = static_cast<Leaf*>(left);
+            ShiftRight(leaf, 0);
+            MoveSlot(from, from->size - 1, leaf, 0);
+            --from->size;
+            ++leaf->size;
+            parent->keys[index - 1] = leaf->Slot(0)->first;
+            return;
+        }
+
+        // The separator goes down, the last key of the sibling goes up
+        Inner* inner = static_cast<Inner*>(child);
+        Inner* from = static_cast<Inner*>(left);
+        std::move_backward(inner->keys, inner->keys + inner->size, inner->keys + inner->size + 1);
+        std::copy_backward(inner->children, inner->children + inner->size + 1, inner->children + inner->size + 2);
+        inner->keys[0] = std::move(parent->keys[index - 1]);
+        inner->children[0] = from->children[from->size];
+        parent->keys[index - 1] = std::move(from->keys[from->size - 1]);
+        --from->size;
+        ++inner->size;
+    }
+
+    static void BorrowFromRight(Inner* parent, size_t index) {
+        Node* child = parent->children[index];
+        Node* right = parent->children[index + 1];
+
+        if (child->is_leaf) {
+            Leaf* leaf = static_cast<Leaf*>(child);
+            Leaf* from = static_cast<Leaf*>(right);
+            MoveSlot(from, 0, leaf, leaf->size++);
+            ShiftLeft(from, 0);
+            --from->size;
+            parent->keys[index] = from->Slot(0)->first;
+            return;
+        }
+
+        Inner* inner = static_cast<Inner*>(child);
+        Inner* from = static_cast<Inner*>(right);
+        inner->keys[inner->size] = std::move(parent->keys[index]);
+        inner->children[inner->size + 1] = from->children[0];
+        ++inner->size;
+        parent->keys[index] = std::move(from->keys[0]);
+        std::move(from->keys + 1, from->keys + from->size, from->keys);
+        std::copy(from->children + 1, from->children + from->size + 1, from->children);
+        --from->size;
+    }
+
+    // Merges children[index + 1] into children[index] and removes the separator between them
+    static void Merge(Inner* parent, size_t index) {
+        Node* left = parent->children[index];
+        Node* right = parent->children[index + 1];
+
+        if (left->is_leaf) {
+            Leaf* to = static_cast<Leaf*>(left);
+            Leaf* from = static_cast<Leaf*>(right);
+            MoveTail(from, 0, to);
+            to->next = from->next;
+            delete from;
+        } else {
+            Inner* to = static_cast<Inner*>(left);
+            Inner* from = static_cast<Inner*>(right);
+            to->keys[to->size] = std::move(parent->keys[index]);
+            std::move(from->keys, from->keys + from->size, to->keys + to->size + 1);
+            std::copy(from->children, from->children + from->size + 1, to->children + to->size + 1);
+            to->size += from->size + 1;
+            delete from;
+        }
+
+        std::move(parent->keys + index + 1, parent->keys + parent->size, parent->keys + index);
+        std::copy(parent->children + index + 2, parent->children + parent->size + 1, parent->children + index + 1);
+        --parent->size;
+    }
+
+    static void Destroy(Node* node) noexcept {
+        if (node->is_leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            for (size_t i = 0; i < leaf->size; ++i) {
+                leaf->Slot(i)->~Pair();
+            }
+            delete leaf;
+            return;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        for (size_t i = 0; i <= inner->size; ++i) {
+            Destroy(inner->children[i]);
+        }
+        delete inner;
+    }
+
+private:
+    Compare comp_;
+    Node* root_ = nullptr;
+    size_t sz_ = 0;
+};
+
+namespace std {
+// Global swap overloading
+template <typename Key, typename Value, typename Compare, size_t NodeBytes>
+// NOLINTNEXTLINE
+void swap(BTreeMap<Key, Value, Compare, NodeBytes>& a, BTreeMap<Key, Value, Compare, NodeBytes>& b) {
+    a.Swap(b);
+}
+}  // namespace std
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../../iterators/map.hpp"
+#include "../btree_map.hpp"
+
+std::vector<int> ConstructRandomKeys(int sz) {
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
+  std::vector<int> res(sz);
+  for (auto& key : res) {
+    key = dist(mt);
+  }
+  return res;
+}
+
+// Insert / Find for the three maps under one name
+template <typename Key, typename Value>
+void Put(Map<Key, Value>& mp, const Key& key) {
+  mp.Insert({key, 1});
+}
+
+template <typename Key, typename Value>
+void Put(BTreeMap<Key, Value>& mp, const Key& key) {
+  mp.Insert({key, 1});
+}
+
+template <typename Key, typename Value>
+void Put(std::map<Key, Value>& mp, const Key& key) {
+  mp.insert({key, 1});
+}
+
+template <typename Key, typename Value>
+bool Contains(const Map<Key, Value>& mp, const Key& key) {
+  return mp.Find(key) != mp.End();
+}
+
+template <typename Key, typename Value>
+bool Contains(const BTreeMap<Key, Value>& mp, const Key& key) {
+  return mp.Find(key) != mp.End();
+}
+
+template <typename Key, typename Value>
+bool Contains(const std::map<Key, Value>& mp, const Key& key) {
+  return mp.find(key) != mp.end();
+}
+
+template <typename MapType>
+void RunRandomInsert(benchmark::State& state) {
+  auto keys = ConstructRandomKeys(state.range(0));
+  for (auto _ : state) {
+    auto mp = std::make_unique<MapType>();
+    for (int key : keys) {
+      Put(*mp, key);
+    }
+    state.PauseTiming();
+    mp.reset();
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+template <typename MapType>
+void RunSortedInsert(benchmark::State& state) {
+  for (auto _ : state) {
+    auto mp = std::make_unique<MapType>();
+    for (int key = 0; key < state.range(0); ++key) {
+      Put(*mp, key);
+    }
+    state.PauseTiming();
+    mp.reset();
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Lookups of present keys in random order: dominated by cache misses on big maps
+template <typename MapType>
+void RunRandomFind(benchmark::State& state) {
+  auto keys = ConstructRandomKeys(state.range(0));
+  MapType mp;
+  for (int key : keys) {
+    Put(mp, key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+  for (auto _ : state) {
+    for (int key : keys) {
+      benchmark::DoNotOptimize(Contains(mp, key));
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void BM_BTreeMapRandomInsert(benchmark::State& state) {
+  RunRandomInsert<BTreeMap<int, int>>(state);
+}
+
+void BM_CustomMapRandomInsert(benchmark::State& state) {
+  RunRandomInsert<Map<int, int>>(state);
+}
+
+void BM_StdMapRandomInsert(benchmark::State& state) {
+  RunRandomInsert<std::map<int, int>>(state);
+}
+
+void BM_BTreeMapSortedInsert(benchmark::State& state) {
+  RunSortedInsert<BTreeMap<int, int>>(state);
+}
+
+void BM_CustomMapSortedInsert(benchmark::State& state) {
+  RunSortedInsert<Map<int, int>>(state);
+}
+
+void BM_StdMapSortedInsert(benchmark::State& state) {
+  RunSortedInsert<std::map<int, int>>(state);
+}
+
+void BM_BTreeMapRandomFind(benchmark::State& state) {
+  RunRandomFind<BTreeMap<int, int>>(state);
+}
+
+void BM_CustomMapRandomFind(benchmark::State& state) {
+  RunRandomFind<Map<int, int>>(state);
+}
+
+void BM_StdMapRandomFind(benchmark::State& state) {
+  RunRandomFind<std::map<int, int>>(state);
+}
+
+
+BENCHMARK(BM_BTreeMapRandomInsert)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapRandomInsert)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapRandomInsert)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BTreeMapSortedInsert)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSortedInsert)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapSortedInsert)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BTreeMapRandomFind)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapRandomFind)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapRandomFind)->Range(1<<10, 1<<22)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../btree_map.hpp"
+
+// Minimal nodes: the tree gets deep on a few hundred keys
+template <typename Key, typename Value>
+using SmallNodeMap = BTreeMap<Key, Value, std::less<Key>, 1>;
+
+class BTreeMapTest: public testing::Test {
+  protected:
+    void SetUp() override {
+      mp.Insert({
+        {1, 5},
+        {3, 10},
+        {5, 90},
+        {10, -10},
+        {90, 0},
+        {-10, 5},
+        {0, 4}
+      });
+      ASSERT_EQ(mp.Size(), sz);
+    }
+
+  BTreeMap<int, int> mp;
+  const size_t sz = 7;
+};
+
+template <typename BTree, typename Key, typename Value>
+void ExpectSameContent(const BTree& mp, const std::map<Key, Value>& expected) {
+  ASSERT_EQ(mp.Size(), expected.size());
+
+  auto it = mp.Begin();
+  for (const auto& val: expected) {
+    ASSERT_NE(it, mp.End());
+    ASSERT_EQ(*it, val);
+    ++it;
+  }
+  ASSERT_EQ(it, mp.End());
+
+  auto values = mp.Values(false);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.rbegin(), expected.rend()));
+}
+
+
+TEST(EmptyBTreeMapTest, DefaultConstructor) {
+  BTreeMap<int, int> map;
+  ASSERT_TRUE(map.IsEmpty());
+  ASSERT_EQ(map.Begin(), map.End());
+  ASSERT_EQ(map.Find(1), map.End());
+  ASSERT_TRUE(map.Values().empty());
+}
+
+TEST(EmptyBTreeMapTest, EraseFromEmpty) {
+  BTreeMap<int, int> map;
+  EXPECT_ANY_THROW(map.Erase(1));
+}
+
+TEST(EmptyBTreeMapTest, EraseOnlyRoot) {
+  BTreeMap<int, int> map;
+  map.Insert({1, 2});
+  map.Erase(1);
+  ASSERT_TRUE(map.IsEmpty());
+  ASSERT_EQ(map.Begin(), map.End());
+}
+
+TEST(EmptyBTreeMapTest, Swap) {
+  BTreeMap<int, int> map;
+  map[1] = 5;
+
+  BTreeMap<int, int> dict;
+  dict[1] = 15;
+  dict[2] = 14;
+
+  std::swap(map, dict);
+
+  ASSERT_EQ(dict.Size(), 1);
+  ASSERT_EQ(map.Size(), 2);
+  ASSERT_EQ(dict[1], 5);
+  ASSERT_EQ(map[1], 15);
+  ASSERT_EQ(map[2], 14);
+}
+
+TEST(EmptyBTreeMapTest, Move) {
+  static_assert(std::is_nothrow_move_constructible_v<BTreeMap<int, int>>);
+  static_assert(std::is_nothrow_move_assignable_v<BTreeMap<int, int>>);
+
+  SmallNodeMap<int, int> map;
+  for (int i = 0; i < 100; ++i) {
+    map[i] = i;
+  }
+
+  SmallNodeMap<int, int> moved(std::move(map));
+  ASSERT_TRUE(map.IsEmpty());
+  ASSERT_EQ(moved.Size(), 100);
+  ASSERT_EQ(moved.Begin()->first, 0);
+
+  map[-1] = -1;
+  map = std::move(moved);
+  ASSERT_EQ(map.Size(), 100);
+  ASSERT_EQ(map.Find(-1), map.End());
+  ASSERT_EQ(map.Find(99)->second, 99);
+}
+
+TEST(EmptyBTreeMapTest, StringAsKey) {
+  SmallNodeMap<std::string, std::string> mp;
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 500; ++i) {
+    auto key = fmt::format("key{}", i * 7919 % 500);
+    mp[key] = std::to_string(i);
+    expected[key] = std::to_string(i);
+  }
+  ExpectSameContent(mp, expected);
+
+  for (int i = 0; i < 500; i += 2) {
+    auto key = fmt::format("key{}", i);
+    mp.Erase(key);
+    expected.erase(key);
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST_F(BTreeMapTest, GetValueUsingOperator) {
+  ASSERT_EQ(mp[5], 90);
+  ASSERT_EQ(mp[-10], 5);
+  ASSERT_EQ(mp[1], 5);
+  ASSERT_EQ(mp[0], 4);
+}
+
+TEST_F(BTreeMapTest, CreateIfNotExist) {
+  ASSERT_EQ(mp[-1], 0);
+  ASSERT_EQ(mp.Size(), sz + 1);
+}
+
+TEST_F(BTreeMapTest, InsertOverwrites) {
+  mp.Insert({5, 6});
+  ASSERT_EQ(mp[5], 6);
+  ASSERT_EQ(mp.Size(), sz);
+}
+
+TEST_F(BTreeMapTest, SortedValues) {
+  auto values = mp.Values(true);
+  for (size_t i = 1; i < values.size(); ++i) {
+    ASSERT_LT(values[i - 1].first, values[i].first);
+  }
+
+  values = mp.Values(false);
+  for (size_t i = 1; i < values.size(); ++i) {
+    ASSERT_GT(values[i - 1].first, values[i].first);
+  }
+}
+
+TEST_F(BTreeMapTest, Find) {
+  auto it = mp.Find(3);
+  ASSERT_NE(it, mp.End());
+  ASSERT_EQ(it->second, 10);
+  ASSERT_EQ((++it)->first, 5);
+  ASSERT_EQ(mp.Find(-11), mp.End());
+}
+
+TEST_F(BTreeMapTest, EraseNotExistingValue) {
+  EXPECT_ANY_THROW(mp.Erase(-100));
+  ASSERT_EQ(mp.Size(), sz);
+}
+
+TEST_F(BTreeMapTest, Clear) {
+  mp.Clear();
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(mp.Begin(), mp.End());
+  mp[1] = 1;
+  ASSERT_EQ(mp.Size(), 1);
+}
+
+TEST(BTreeMapSplitMergeTest, SortedInsertAndErase) {
+  SmallNodeMap<int, int> mp;
+  std::map<int, int> expected;
+  for (int i = 0; i < 10000; ++i) {
+    mp.Insert({i, -i});
+    expected.insert({i, -i});
+  }
+  ExpectSameContent(mp, expected);
+
+  for (int i = 9999; i >= 0; i -= 2) {
+    mp.Erase(i);
+    expected.erase(i);
+  }
+  ExpectSameContent(mp, expected);
+
+  for (int i = 0; i < 10000; i += 2) {
+    mp.Erase(i);
+  }
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(mp.Begin(), mp.End());
+}
+
+TEST(BTreeMapSplitMergeTest, RandomOperations) {
+  std::mt19937 mt(42);
+  SmallNodeMap<int, int> small;
+  BTreeMap<int, int> large;
+  std::map<int, int> expected;
+
+  for (int i = 0; i < 50000; ++i) {
+    int key = static_cast<int>(mt() % 2000);
+    switch (mt() % 4) {
+      case 0:
+        small.Insert({key, i});
+        large.Insert({key, i});
+        expected.insert_or_assign(key, i);
+        break;
+      case 1:
+        small[key] = i;
+        large[key] = i;
+        expected[key] = i;
+        break;
+      case 2:
+        if (expected.erase(key) == 1) {
+          small.Erase(key);
+          large.Erase(key);
+        } else {
+          EXPECT_ANY_THROW(small.Erase(key));
+          EXPECT_ANY_THROW(large.Erase(key));
+        }
+        break;
+      case 3:
+        ASSERT_EQ(small.Find(key) != small.End(), expected.contains(key));
+        ASSERT_EQ(large.Find(key) != large.End(), expected.contains(key));
+        break;
+    }
+
+    if (i % 5000 == 0) {
+      ExpectSameContent(small, expected);
+      ExpectSameContent(large, expected);
+    }
+  }
+  ExpectSameContent(small, expected);
+  ExpectSameContent(large, expected);
+}
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,544 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace detail::concurrent {
+
+// Skip list levels: with 1/4 of nodes going one level up
+// that is enough for 4^16 elements
+inline constexpr int kMaxLevel = 16;
+
+// Reader counters of different threads live in different cache lines
+inline constexpr size_t kCacheLine = 64;
+inline constexpr size_t kReaderSlots = 64;
+
+// Retired nodes are reclaimed in batches
+inline constexpr size_t kCollectBatch = 256;
+
+// Lock of a single node: writers hold it only for a few pointer stores
+class SpinLock {
+public:
+    void lock() noexcept {
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock() noexcept {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> locked_ = false;
+};
+
+// Every thread gets its own reader slot while there are free ones
+inline size_t ThreadSlot() noexcept {
+    static std::atomic<size_t> next_slot = 0;
+    thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kReaderSlots;
+    return slot;
+}
+
+// Height of a new node: 1 with probability 3/4, 2 with 3/16 and so on
+inline int RandomLevel() noexcept {
+    thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ (ThreadSlot() + 1) * 0xBF58476D1CE4E5B9ull;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    int level = 1 + std::countr_zero(state | (uint64_t{1} << 62)) / 2;
+    return std::min(level, kMaxLevel);
+}
+
+}  // namespace detail::concurrent
+
+// Ordered map for many threads: a lazy skip list.
+//
+// Find, Contains and iteration take no locks and never wait for writers.
+// Insert and Erase lock only the nodes whose links they change, so writers
+// to different parts of the map don't interfere.
+//
+// Elements are immutable once published: Insert of an existing key links
+// a new node right after the old one and only then marks the old one as
+// removed, so a reader sees either the old or the new value, never a torn one.
+//
+// Unlinked nodes are freed by epoch-based reclamation: every operation
+// registers itself in the current epoch, and a node is freed only after two
+// epoch changes, when no operation that could have seen it is running.
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class ConcurrentMap {
+    class Node;
+    using Preds = std::array<Node*, detail::concurrent::kMaxLevel>;
+
+public:
+    ConcurrentMap() : head_(Node::Create(detail::concurrent::kMaxLevel)) {
+    }
+
+    explicit ConcurrentMap(const Compare& comp) : ConcurrentMap() {
+        comp_ = comp;
+    }
+
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+    // Copy of the value, if the key is present
+    std::optional<Value> Find(const Key& key) const {
+        Guard guard(*this);
+        Node* node = FindLive(key);
+        if (node == nullptr) {
+            return std::nullopt;
+        }
+        return node->data_.second;
+    }
+
+    bool Contains(const Key& key) const {
+        Guard guard(*this);
+        return FindLive(key) != nullptr;
+    }
+
+    // Inserts the pair or replaces the value of an existing key
+    void Insert(const std::pair<const Key, Value>& val) {
+        Guard guard(*this);
+        Preds preds;
+        Preds succs;
+        NodePtr spare;
+
+        while (true) {
+            int found = FindNode(val.first, preds, succs);
+
+            if (found >= 0) {
+                Node* old = succs[found];
+                if (!IsReady(old, found)) {
+                    // Somebody else is inserting, replacing or erasing it right now
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (spare == nullptr || spare->height_ != old->height_) {
+                    spare.reset(Node::Create(old->height_, val.first, val.second));
+                }
+                if (Replace(old, spare.get(), preds, succs)) {
+                    spare.release();
+                    return;
+                }
+                continue;
+            }
+
+            if (spare == nullptr) {
+                spare.reset(Node::Create(detail::concurrent::RandomLevel(), val.first, val.second));
+            }
+            if (Link(spare.get(), preds, succs)) {
+                spare.release();
+                sz_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    void Insert(const std::initializer_list<std::pair<const Key, Value>>& values) {
+        for (const auto& val : values) {
+            Insert(val);
+        }
+    }
+
+    // Returns false if there was no such key
+    bool Erase(const Key& key) {
+        Guard guard(*this);
+        Preds preds;
+        Preds succs;
+
+        while (true) {
+            int found = FindNode(key, preds, succs);
+            if (found < 0) {
+                return false;
+            }
+
+            Node* victim = succs[found];
+            if (!IsReady(victim, found)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            {
+                std::lock_guard lock(victim->lock_);
+                if (victim->marked_.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                // Linearization point: the element is removed for all readers
+                victim->marked_.store(true, std::memory_order_release);
+                Unlink(victim, preds, succs);
+            }
+
+            sz_.fetch_sub(1, std::memory_order_relaxed);
+            Retire(victim);
+            return true;
+        }
+    }
+
+    // Calls func for every element in increasing order of keys. Weakly
+    // consistent: elements changed during the walk may or may not be seen
+    template <typename Func>
+    void ForEach(Func&& func) const {
+        Guard guard(*this);
+        Node* last = nullptr;
+        for (Node* node = Next(head_, 0); node != nullptr; node = Next(node, 0)) {
+            // A replacement right after an already visited node isn't visited again
+            if (last != nullptr && !comp_(last->data_.first, node->data_.first)) {
+                continue;
+            }
+            if (IsLive(node)) {
+                func(node->data_);
+                last = node;
+            }
+        }
+    }
+
+    std::vector<std::pair<const Key, Value>> Values(bool is_increase = true) const {
+        std::vector<std::pair<const Key, Value>> res;
+        res.reserve(Size());
+        ForEach([&res](const auto& val) { res.push_back(val); });
+        if (is_increase) {
+            return res;
+        }
+
+        // Keys are const: the copy can't be reversed in place
+        std::vector<std::pair<const Key, Value>> reversed;
+        reversed.reserve(res.size());
+        for (auto it = res.rbegin(); it != res.rend(); ++it) {
+            reversed.push_back(*it);
+        }
+        return reversed;
+    }
+
+    // Exact only when no writer is running
+    inline size_t Size() const noexcept {
+        return sz_.load(std::memory_order_relaxed);
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return Size() == 0;
+    }
+
+    // Not thread-safe: no other operation may run concurrently
+    void Clear() noexcept {
+        Node* node = Next(head_, 0);
+        while (node != nullptr) {
+            Node* next = Next(node, 0);
+            Node::Destroy(node);
+            node = next;
+        }
+        for (int level = 0; level < detail::concurrent::kMaxLevel; ++level) {
+            head_->Links()[level].store(nullptr, std::memory_order_relaxed);
+        }
+        sz_.store(0, std::memory_order_relaxed);
+
+        for (const auto& [epoch, retired] : retired_) {
+            Node::Destroy(retired);
+        }
+        retired_.clear();
+    }
+
+    // Not thread-safe
+    ~ConcurrentMap() {
+        Clear();
+        Node::Destroy(head_);
+    }
+
+private:
+    class alignas(std::atomic<Node*>) Node {
+        friend class ConcurrentMap;
+        using Link = std::atomic<Node*>;
+
+    public:
+        // Links are allocated right after the node
+        template <typename... Args>
+        static Node* Create(int height, Args&&... args) {
+            void* memory = ::operator new(sizeof(Node) + height * sizeof(Link));
+            try {
+                return new (memory) Node(height, std::forward<Args>(args)...);
+            } catch (...) {
+                ::operator delete(memory);
+                throw;
+            }
+        }
+
+        static void Destroy(Node* node) noexcept {
+            node->~Node();
+            ::operator delete(node);
+        }
+
+        inline Link* Links() noexcept {
+            return reinterpret_cast<Link*>(this + 1);
+        }
+
+    private:
+        template <typename... Args>
+        explicit Node(int height, Args&&... args) : data_(std::forward<Args>(args)...), height_(height) {
+            for (int level = 0; level < height; ++level) {
+                new (Links() + level) Link(nullptr);
+            }
+        }
+
+    private:
+        const std::pair<const Key, Value> data_;
+        const int height_;
+        // Unlinking has started: the node is not in the map anymore
+        std::atomic<bool> marked_ = false;
+        // Linked on all levels: the node is in the map
+        std::atomic<bool> fully_linked_ = false;
+        detail::concurrent::SpinLock lock_;
+    };
+
+    struct NodeDeleter {
+        void operator()(Node* node) const noexcept {
+            Node::Destroy(node);
+        }
+    };
+
+    using NodePtr = std::unique_ptr<Node, NodeDeleter>;
+
+    struct alignas(detail::concurrent::kCacheLine) ReaderSlot {
+        // Running operations that entered in even and odd epochs
+        std::atomic<size_t> active[2] = {0, 0};
+    };
+
+    // Registers an operation in the current epoch for its whole duration
+    class Guard {
+    public:
+        explicit Guard(const ConcurrentMap& map) : slot_(map.readers_[detail::concurrent::ThreadSlot()]) {
+            while (true) {
+                uint64_t epoch = map.epoch_.load();
+                parity_ = epoch & 1;
+                slot_.active[parity_].fetch_add(1);
+                // The epoch may have moved on before the counter was seen
+                if (map.epoch_.load() == epoch) {
+                    break;
+                }
+                slot_.active[parity_].fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        ~Guard() {
+            slot_.active[parity_].fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        ReaderSlot& slot_;
+        size_t parity_;
+    };
+
+    static inline Node* Next(Node* node, int level) noexcept {
+        return node->Links()[level].load(std::memory_order_acquire);
+    }
+
+    static inline bool IsLive(Node* node) noexcept {
+        return node->fully_linked_.load(std::memory_order_acquire) && !node->marked_.load(std::memory_order_acquire);
+    }
+
+    // A node found on its top level can be replaced or erased
+    static inline bool IsReady(Node* node, int found) noexcept {
+        return IsLive(node) && node->height_ == found + 1;
+    }
+
+    // Fills the last nodes with smaller keys and the nodes after them on every
+    // level. Returns the highest level with an equal key, or -1
+    int FindNode(const Key& key, Preds& preds, Preds& succs) const {
+        int found = -1;
+        Node* pred = head_;
+
+        for (int level = detail::concurrent::kMaxLevel - 1; level >= 0; --level) {
+            Node* curr = Next(pred, level);
+            while (curr != nullptr && comp_(curr->data_.first, key)) {
+                pred = curr;
+                curr = Next(pred, level);
+            }
+            if (found < 0 && curr != nullptr && !comp_(key, curr->data_.first)) {
+                found = level;
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return found;
+    }
+
+    // Lock-free lookup. A replaced node is followed by its replacement,
+    // so after a removed node with the key the next one is checked too
+    Node* FindLive(const Key& key) const {
+        Node* pred = head_;
+        Node* curr = nullptr;
+
+        for (int level = detail::concurrent::kMaxLevel - 1; level >= 0; --level) {
+            curr = Next(pred, level);
+            while (curr != nullptr && comp_(curr->data_.first, key)) {
+                pred = curr;
+                curr = Next(pred, level);
+            }
+        }
+
+        for (; curr != nullptr && !comp_(key, curr->data_.first); curr = Next(curr, 0)) {
+            if (IsLive(curr)) {
+                return curr;
+            }
+        }
+        return nullptr;
+    }
+
+    // Locks distinct predecessors on levels [0, height) from the bottom up
+    // and checks that they are still in the map and point to succs.
+    // On failure everything is unlocked
+    static bool LockPreds(const Preds& preds, const Preds& succs, int height) noexcept {
+        for (int level = 0; level < height; ++level) {
+            if (level == 0 || preds[level] != preds[level - 1]) {
+                preds[level]->lock_.lock();
+            }
+            if (preds[level]->marked_.load(std::memory_order_relaxed) ||
+                Next(preds[level], level) != succs[level]) {
+                UnlockPreds(preds, level + 1);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void UnlockPreds(const Preds& preds, int height) noexcept {
+        for (int level = 0; level < height; ++level) {
+            if (level == 0 || preds[level] != preds[level - 1]) {
+                preds[level]->lock_.unlock();
+            }
+        }
+    }
+
+    // Links a new node between preds and succs, bottom up
+    bool Link(Node* node, const Preds& preds, const Preds& succs) noexcept {
+        int height = node->height_;
+
+        for (int level = 0; level < height; ++level) {
+            Node* succ = succs[level];
+            if (succ != nullptr && succ->marked_.load(std::memory_order_acquire)) {
+                return false;
+            }
+        }
+        if (!LockPreds(preds, succs, height)) {
+            return false;
+        }
+
+        for (int level = 0; level < height; ++level) {
+            node->Links()[level].store(succs[level], std::memory_order_relaxed);
+        }
+        for (int level = 0; level < height; ++level) {
+            preds[level]->Links()[level].store(node, std::memory_order_release);
+        }
+        // Linearization point of the insertion
+        node->fully_linked_.store(true, std::memory_order_release);
+
+        UnlockPreds(preds, height);
+        return true;
+    }
+
+    // Puts node of the same height right after old on every level, then
+    // removes old. Returns false if old was removed by somebody else first
+    bool Replace(Node* old, Node* node, Preds& preds, Preds& succs) {
+        std::unique_lock lock(old->lock_);
+        if (old->marked_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        // Links of old change only under its lock
+        for (int level = 0; level < old->height_; ++level) {
+            node->Links()[level].store(old->Links()[level].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        for (int level = 0; level < old->height_; ++level) {
+            old->Links()[level].store(node, std::memory_order_release);
+        }
+        node->fully_linked_.store(true, std::memory_order_release);
+        // Linearization point: readers that see old removed go on to node
+        old->marked_.store(true, std::memory_order_release);
+
+        Unlink(old, preds, succs);
+        lock.unlock();
+
+        Retire(old);
+        return true;
+    }
+
+    // Removes the marked and locked victim from all levels, top down
+    void Unlink(Node* victim, Preds& preds, Preds& succs) {
+        while (!LockPreds(preds, VictimOnAllLevels(victim), victim->height_)) {
+            FindNode(victim->data_.first, preds, succs);
+        }
+
+        for (int level = victim->height_ - 1; level >= 0; --level) {
+            preds[level]->Links()[level].store(Next(victim, level), std::memory_order_release);
+        }
+        UnlockPreds(preds, victim->height_);
+    }
+
+    static Preds VictimOnAllLevels(Node* victim) noexcept {
+        Preds victims;
+        victims.fill(victim);
+        return victims;
+    }
+
+    // The node is unreachable for new operations, but running ones may
+    // still hold it: it waits until the epoch advances twice
+    void Retire(Node* node) {
+        std::lock_guard lock(retired_mutex_);
+        retired_.emplace_back(epoch_.load(), node);
+        if (retired_.size() >= next_collect_) {
+            Collect();
+        }
+    }
+
+    // Advances the epoch if nobody is left in the previous one, then frees
+    // nodes retired two epochs ago or earlier
+    void Collect() noexcept {
+        uint64_t epoch = epoch_.load();
+
+        size_t active = 0;
+        for (const auto& slot : readers_) {
+            active += slot.active[(epoch + 1) & 1].load();
+        }
+        if (active == 0) {
+            epoch_.store(++epoch);
+        }
+
+        auto alive = std::partition(retired_.begin(), retired_.end(),
+                                    [epoch](const auto& retired) { return retired.first + 2 > epoch; });
+        for (auto it = alive; it != retired_.end(); ++it) {
+            Node::Destroy(it->second);
+        }
+        retired_.erase(alive, retired_.end());
+
+        next_collect_ = std::max(detail::concurrent::kCollectBatch, 2 * retired_.size());
+    }
+
+private:
+    Compare comp_;
+    Node* head_;
+    std::atomic<size_t> sz_ = 0;
+
+    std::atomic<uint64_t> epoch_ = 0;
+    mutable std::array<ReaderSlot, detail::concurrent::kReaderSlots> readers_;
+
+    std::mutex retired_mutex_;
+    // Epoch of retirement and the node
+    std::vector<std::pair<uint64_t, Node*>> retired_;
+    size_t next_collect_ = detail::concurrent::kCollectBatch;
+};
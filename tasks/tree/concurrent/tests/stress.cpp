@@ -0,0 +1,133 @@
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../concurrent_map.hpp"
+#include "../../iterators/map.hpp"
+
+// Keys of all operations are taken from [0, kKeys), half of them are present
+constexpr int kKeys = 1 << 16;
+
+// One Map behind a single mutex: what ConcurrentMap replaces
+class LockedMap {
+public:
+  bool Contains(int key) {
+    std::lock_guard lock(mutex_);
+    return mp_.Find(key) != mp_.End();
+  }
+
+  void Insert(int key, int value) {
+    std::lock_guard lock(mutex_);
+    mp_.Insert({key, value});
+  }
+
+  void Erase(int key) {
+    std::lock_guard lock(mutex_);
+    if (mp_.Find(key) != mp_.End()) {
+      mp_.Erase(key);
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  Map<int, int> mp_;
+};
+
+// Readers share the lock: writers still stop everybody
+class SharedLockedMap {
+public:
+  bool Contains(int key) {
+    std::shared_lock lock(mutex_);
+    return mp_.Find(key) != mp_.End();
+  }
+
+  void Insert(int key, int value) {
+    std::unique_lock lock(mutex_);
+    mp_.Insert({key, value});
+  }
+
+  void Erase(int key) {
+    std::unique_lock lock(mutex_);
+    if (mp_.Find(key) != mp_.End()) {
+      mp_.Erase(key);
+    }
+  }
+
+private:
+  std::shared_mutex mutex_;
+  Map<int, int> mp_;
+};
+
+class SkipListMap {
+public:
+  bool Contains(int key) {
+    return mp_.Contains(key);
+  }
+
+  void Insert(int key, int value) {
+    mp_.Insert({key, value});
+  }
+
+  void Erase(int key) {
+    mp_.Erase(key);
+  }
+
+private:
+  ConcurrentMap<int, int> mp_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// state.range(0) - percent of reads, the rest are inserts and erases in equal
+// shares, so the size of the map stays about the same
+template <typename SharedMap>
+void BM_Mixed(benchmark::State& state) {
+  static std::unique_ptr<SharedMap> mp;
+  if (state.thread_index() == 0) {
+    mp = std::make_unique<SharedMap>();
+    for (int key = 0; key < kKeys; key += 2) {
+      mp->Insert(key, key);
+    }
+  }
+
+  std::mt19937 mt(state.thread_index() + 1);
+  const unsigned reads = state.range(0);
+  for (auto _ : state) {
+    int key = static_cast<int>(mt() % kKeys);
+    unsigned op = mt() % 100;
+    if (op < reads) {
+      benchmark::DoNotOptimize(mp->Contains(key));
+    } else if (op % 2 == 0) {
+      mp->Insert(key, key);
+    } else {
+      mp->Erase(key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    mp.reset();
+  }
+}
+
+void BM_LockedMap(benchmark::State& state) {
+  BM_Mixed<LockedMap>(state);
+}
+
+void BM_SharedLockedMap(benchmark::State& state) {
+  BM_Mixed<SharedLockedMap>(state);
+}
+
+void BM_ConcurrentMap(benchmark::State& state) {
+  BM_Mixed<SkipListMap>(state);
+}
+
+
+BENCHMARK(BM_LockedMap)->Arg(95)->Arg(50)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_SharedLockedMap)->Arg(95)->Arg(50)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_ConcurrentMap)->Arg(95)->Arg(50)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
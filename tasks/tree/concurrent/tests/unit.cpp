@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../concurrent_map.hpp"
+
+class ConcurrentMapTest: public testing::Test {
+  protected:
+    void SetUp() override {
+      mp.Insert({
+        {1, 5},
+        {3, 10},
+        {5, 90},
+        {10, -10},
+        {90, 0},
+        {-10, 5},
+        {0, 4}
+      });
+      ASSERT_EQ(mp.Size(), sz);
+    }
+
+  ConcurrentMap<int, int> mp;
+  const size_t sz = 7;
+};
+
+template <typename Key, typename Value>
+void ExpectSameContent(const ConcurrentMap<Key, Value>& mp, const std::map<Key, Value>& expected) {
+  ASSERT_EQ(mp.Size(), expected.size());
+
+  auto values = mp.Values();
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+
+  values = mp.Values(false);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.rbegin(), expected.rend()));
+}
+
+// Runs func(0), ..., func(threads - 1) at the same time
+template <typename Func>
+void RunThreads(size_t threads, Func func) {
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back(func, t);
+  }
+  for (auto& worker: workers) {
+    worker.join();
+  }
+}
+
+
+TEST(EmptyConcurrentMapTest, DefaultConstructor) {
+  ConcurrentMap<int, int> mp;
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(mp.Size(), 0);
+  ASSERT_FALSE(mp.Find(0).has_value());
+  ASSERT_FALSE(mp.Erase(0));
+  ASSERT_TRUE(mp.Values().empty());
+}
+
+TEST(EmptyConcurrentMapTest, StringAsKey) {
+  ConcurrentMap<std::string, std::string> mp;
+  mp.Insert({"b", "second"});
+  mp.Insert({"a", "first"});
+  mp.Insert({"b", "replaced"});
+
+  ASSERT_EQ(mp.Size(), 2);
+  ASSERT_EQ(mp.Find("a"), "first");
+  ASSERT_EQ(mp.Find("b"), "replaced");
+  ASSERT_TRUE(mp.Erase("a"));
+  ASSERT_FALSE(mp.Contains("a"));
+}
+
+TEST_F(ConcurrentMapTest, Find) {
+  ASSERT_EQ(mp.Find(5), 90);
+  ASSERT_EQ(mp.Find(-10), 5);
+  ASSERT_FALSE(mp.Find(6).has_value());
+  ASSERT_TRUE(mp.Contains(90));
+  ASSERT_FALSE(mp.Contains(91));
+}
+
+TEST_F(ConcurrentMapTest, InsertReplacesValue) {
+  mp.Insert({5, 1});
+  ASSERT_EQ(mp.Find(5), 1);
+  ASSERT_EQ(mp.Size(), sz);
+}
+
+TEST_F(ConcurrentMapTest, Erase) {
+  ASSERT_TRUE(mp.Erase(5));
+  ASSERT_FALSE(mp.Erase(5));
+  ASSERT_FALSE(mp.Contains(5));
+  ASSERT_EQ(mp.Size(), sz - 1);
+}
+
+TEST_F(ConcurrentMapTest, SortedValues) {
+  std::vector<int> keys;
+  mp.ForEach([&keys](const auto& val) { keys.push_back(val.first); });
+  ASSERT_EQ(keys, (std::vector<int>{-10, 0, 1, 3, 5, 10, 90}));
+}
+
+TEST_F(ConcurrentMapTest, Clear) {
+  mp.Clear();
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_TRUE(mp.Values().empty());
+  mp.Insert({1, 1});
+  ASSERT_EQ(mp.Find(1), 1);
+}
+
+TEST(EmptyConcurrentMapTest, RandomOperations) {
+  std::mt19937 mt(42);
+  ConcurrentMap<int, int> mp;
+  std::map<int, int> expected;
+
+  for (int i = 0; i < 50000; ++i) {
+    int key = static_cast<int>(mt() % 2000);
+    switch (mt() % 3) {
+      case 0:
+        mp.Insert({key, i});
+        expected.insert_or_assign(key, i);
+        break;
+      case 1:
+        ASSERT_EQ(mp.Erase(key), expected.erase(key) == 1);
+        break;
+      case 2:
+        auto it = expected.find(key);
+        ASSERT_EQ(mp.Find(key), it == expected.end() ? std::nullopt : std::optional<int>(it->second));
+        break;
+    }
+
+    if (i % 5000 == 0) {
+      ExpectSameContent(mp, expected);
+    }
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST(ParallelConcurrentMapTest, DisjointWriters) {
+  ConcurrentMap<int, int> mp;
+  const int threads = 8;
+  const int per_thread = 20000;
+
+  RunThreads(threads, [&](size_t t) {
+    for (int i = 0; i < per_thread; ++i) {
+      mp.Insert({i * threads + static_cast<int>(t), i});
+    }
+    // Every second key of the thread goes away again
+    for (int i = 0; i < per_thread; i += 2) {
+      ASSERT_TRUE(mp.Erase(i * threads + static_cast<int>(t)));
+    }
+  });
+
+  std::map<int, int> expected;
+  for (int t = 0; t < threads; ++t) {
+    for (int i = 1; i < per_thread; i += 2) {
+      expected[i * threads + t] = i;
+    }
+  }
+  ExpectSameContent(mp, expected);
+}
+
+// Writers fight over the same keys; every element they insert has
+// value = 3 * key + 1, so a reader must never see anything else
+TEST(ParallelConcurrentMapTest, ReadersSeeWholeElements) {
+  ConcurrentMap<int, int> mp;
+  const int keys = 512;
+  std::atomic<bool> done = false;
+
+  std::thread reader([&] {
+    std::mt19937 mt(1);
+    while (!done.load()) {
+      int key = static_cast<int>(mt() % keys);
+      auto value = mp.Find(key);
+      ASSERT_TRUE(!value.has_value() || *value == 3 * key + 1);
+
+      int previous = -1;
+      mp.ForEach([&](const auto& val) {
+        ASSERT_LT(previous, val.first);
+        ASSERT_EQ(val.second, 3 * val.first + 1);
+        previous = val.first;
+      });
+    }
+  });
+
+  RunThreads(6, [&](size_t t) {
+    std::mt19937 mt(static_cast<unsigned>(t));
+    for (int i = 0; i < 50000; ++i) {
+      int key = static_cast<int>(mt() % keys);
+      if (mt() % 2 == 0) {
+        mp.Insert({key, 3 * key + 1});
+      } else {
+        mp.Erase(key);
+      }
+    }
+  });
+  done.store(true);
+  reader.join();
+
+  auto values = mp.Values();
+  ASSERT_EQ(values.size(), mp.Size());
+  for (const auto& [key, value]: values) {
+    ASSERT_EQ(value, 3 * key + 1);
+  }
+}
+
+// Each key is incremented by exactly one thread through Find + Insert,
+// so no update may be lost while other keys are replaced and erased
+TEST(ParallelConcurrentMapTest, NoLostUpdates) {
+  ConcurrentMap<int, std::string> mp;
+  const int threads = 4;
+  const int rounds = 2000;
+
+  RunThreads(threads, [&](size_t t) {
+    int own = static_cast<int>(t);
+    for (int i = 0; i < rounds; ++i) {
+      auto value = mp.Find(own);
+      mp.Insert({own, value.value_or("") + "x"});
+      mp.Insert({1000 + i, "noise"});
+      mp.Erase(1000 + i);
+    }
+  });
+
+  for (int t = 0; t < threads; ++t) {
+    ASSERT_EQ(mp.Find(t), std::string(rounds, 'x'));
+  }
+  ASSERT_EQ(mp.Size(), threads);
+}
+
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -1,442 +1,1690 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
+#include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
-#include "../detail/exceptions.hpp"
+namespace detail::map {
 
-template <typename Key, typename Value, typename Compare = std::less<Key>>
+// With a transparent Compare (like std::less<>) lookups accept anything
+// comparable with Key as is, without constructing a temporary Key
+template <typename K, typename Compare, typename Key>
+concept TransparentKey = requires { typename Compare::is_transparent; } && !std::is_same_v<K, Key>;
+
+// Stands for the generation of nodes and iterators when there are no checks
+struct NoGeneration {};
+
+}  // namespace detail::map
+
+// Node storage policies of Map
+
+// Every node is a separate new / delete
+template <typename T>
+class HeapStorage {
+public:
+    // Release() can't free nodes: Clear() deletes them one by one
+    static constexpr bool kReleasesAll = false;
+    // Any instance frees any node, so Merge moves nodes between maps
+    static constexpr bool kAdoptsNodes = true;
+
+    template <typename... Args>
+    T* New(Args&&... args) {
+        return new T(std::forward<Args>(args)...);
+    }
+
+    void Delete(T* object) noexcept {
+        delete object;
+    }
+
+    void Release() noexcept {
+    }
+
+    void Swap(HeapStorage&) noexcept {
+    }
+};
+
+// Nodes are bump-allocated from slabs of SlabSize cells, erased ones go
+// to a free list and are reused first. Release() frees whole slabs without
+// calling destructors, so clearing a map of trivially destructible
+// elements is O(number of slabs) instead of O(n)
+template <typename T, size_t SlabSize = 1024>
+class ArenaStorage {
+    static_assert(SlabSize > 0, "Slab must hold at least one object");
+
+public:
+    static constexpr bool kReleasesAll = true;
+    // A node belongs to the slab it came from: Merge copies nodes
+    static constexpr bool kAdoptsNodes = false;
+
+    ArenaStorage() = default;
+
+    ArenaStorage(const ArenaStorage&) = delete;
+    ArenaStorage& operator=(const ArenaStorage&) = delete;
+
+    template <typename... Args>
+    T* New(Args&&... args) {
+        Cell* cell = free_;
+        if (cell != nullptr) {
+            free_ = cell->next;
+        } else {
+            if (bump_ == bump_end_) {
+                Slab* slab = new Slab;
+                slab->next = slabs_;
+                slabs_ = slab;
+                bump_ = slab->cells;
+                bump_end_ = slab->cells + SlabSize;
+            }
+            cell = bump_++;
+        }
+
+        try {
+            return new (cell->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            cell->next = free_;
+            free_ = cell;
+            throw;
+        }
+    }
+
+    void Delete(T* object) noexcept {
+        object->~T();
+        Cell* cell = reinterpret_cast<Cell*>(object);
+        cell->next = free_;
+        free_ = cell;
+    }
+
+    void Release() noexcept {
+        while (slabs_ != nullptr) {
+            Slab* next = slabs_->next;
+            delete slabs_;
+            slabs_ = next;
+        }
+        free_ = nullptr;
+        bump_ = bump_end_ = nullptr;
+    }
+
+    void Swap(ArenaStorage& other) noexcept {
+        std::swap(slabs_, other.slabs_);
+        std::swap(free_, other.free_);
+        std::swap(bump_, other.bump_);
+        std::swap(bump_end_, other.bump_end_);
+    }
+
+    ~ArenaStorage() {
+        Release();
+    }
+
+private:
+    union Cell {
+        Cell* next;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    struct Slab {
+        Slab* next;
+        Cell cells[SlabSize];
+    };
+
+private:
+    Slab* slabs_ = nullptr;
+    Cell* free_ = nullptr;
+    // Never used cells of the newest slab
+    Cell* bump_ = nullptr;
+    Cell* bump_end_ = nullptr;
+};
+
+// Instrumentation policies of Map
+
+// Counters of Map operations since construction or ResetStats()
+struct MapStats {
+    // Descents from the root: lookups, inserts, erasures, order statistics
+    size_t lookups = 0;
+    size_t comparisons = 0;
+    size_t node_visits = 0;
+    // The deepest node reached by a descent, the root has depth 1
+    size_t max_depth = 0;
+    size_t rotations = 0;
+    size_t allocations = 0;
+
+    double ComparisonsPerLookup() const noexcept {
+        return lookups == 0 ? 0 : static_cast<double>(comparisons) / lookups;
+    }
+
+    // Every descent visits one node per level
+    double AverageDepth() const noexcept {
+        return lookups == 0 ? 0 : static_cast<double>(node_visits) / lookups;
+    }
+};
+
+// Hooks compile to nothing, Stats() is always empty
+class NoInstrumentation {
+public:
+    inline void OnLookup() noexcept {
+    }
+
+    inline void OnVisit() noexcept {
+    }
+
+    inline void OnCompare() noexcept {
+    }
+
+    inline void OnRotation() noexcept {
+    }
+
+    inline void OnAllocate() noexcept {
+    }
+
+    inline MapStats Stats() const noexcept {
+        return {};
+    }
+
+    inline void Reset() noexcept {
+    }
+};
+
+// Counts everything. Not thread-safe, like Map itself: even const
+// lookups change the counters
+class CountingInstrumentation {
+public:
+    inline void OnLookup() noexcept {
+        ++stats_.lookups;
+        depth_ = 0;
+    }
+
+    inline void OnVisit() noexcept {
+        ++stats_.node_visits;
+        stats_.max_depth = std::max(stats_.max_depth, ++depth_);
+    }
+
+    inline void OnCompare() noexcept {
+        ++stats_.comparisons;
+    }
+
+    inline void OnRotation() noexcept {
+        ++stats_.rotations;
+    }
+
+    inline void OnAllocate() noexcept {
+        ++stats_.allocations;
+    }
+
+    inline MapStats Stats() const noexcept {
+        return stats_;
+    }
+
+    inline void Reset() noexcept {
+        stats_ = MapStats();
+    }
+
+private:
+    MapStats stats_;
+    // Depth of the current descent
+    size_t depth_ = 0;
+};
+
+// Iterator check policies of Map
+
+// Nothing is checked: an iterator to an erased element dangles,
+// sanitizers catch its use
+struct UncheckedIterators {
+    static constexpr bool kEnabled = false;
+};
+
+// Nodes and MapIterator keep generations: dereferencing, ++, -- and
+// Erase(it) on an iterator to an erased element throw std::logic_error.
+// Erased nodes are reused, not freed, until Clear()
+struct CheckedIterators {
+    static constexpr bool kEnabled = true;
+};
+
+// Ordered map on a threaded AVL tree.
+// Right links of nodes without a right subtree are threads to the next node,
+// left links of nodes without a left subtree are threads to the previous one,
+// so iteration in both directions needs neither a stack nor parent pointers.
+// Insert, Erase, Find and operator[] are O(log n) for any insertion order.
+// Nodes also keep subtree sizes, so order statistics are O(log n) too.
+// Storage decides where nodes live: see HeapStorage and ArenaStorage.
+// Instrumentation counts comparisons, depths and rotations: see
+// CountingInstrumentation and Stats().
+// IteratorChecks catches stale iterators: see CheckedIterators.
+template <typename Key, typename Value, typename Compare = std::less<Key>,
+          template <typename> class Storage = HeapStorage, typename Instrumentation = NoInstrumentation,
+          typename IteratorChecks = UncheckedIterators>
 class Map {
 
-    class Node;
+    class Node;
+
+    using Generation = std::conditional_t<IteratorChecks::kEnabled, uint32_t, detail::map::NoGeneration>;
+
+    // AVL tree of 2^64 nodes is lower than 1.45 * 64
+    static constexpr size_t kMaxHeight = 96;
+
+public:
+    class MapIterator {
+        friend class Map;
+
+    public:
+        // NOLINTNEXTLINE
+        using value_type = std::pair<const Key, Value>;
+        // NOLINTNEXTLINE
+        using reference_type = value_type&;
+        // NOLINTNEXTLINE
+        using pointer_type = value_type*;
+        // NOLINTNEXTLINE
+        using difference_type = std::ptrdiff_t;
+        // NOLINTNEXTLINE
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        inline bool operator==(const MapIterator& other) const {
+            return this->current_ == other.current_;
+        };
+
+        inline bool operator!=(const MapIterator& other) const {
+            return this->current_ != other.current_;
+        };
+
+        inline reference_type operator*() const {
+            Check();
+            return this->current_->data_;
+        };
+
+        MapIterator& operator++() {
+            Check();
+            Reset(Next(this->current_));
+            return *this;
+        };
+
+        MapIterator operator++(int) {
+            MapIterator copy = *this;
+            operator++();
+            return copy;
+        };
+
+        // --End() is the greatest element
+        MapIterator& operator--() {
+            Check();
+            Reset(Prev(this->current_));
+            return *this;
+        };
+
+        MapIterator operator--(int) {
+            MapIterator copy = *this;
+            operator--();
+            return copy;
+        };
+
+        inline pointer_type operator->() const {
+            Check();
+            return &current_->data_;
+        };
+
+    private:
+        explicit MapIterator(Node* current) : current_(current), generation_(current->generation_) {
+        }
+
+        inline void Reset(Node* current) noexcept {
+            current_ = current;
+            generation_ = current->generation_;
+        }
+
+        // The generation of a node changes when its element is erased and
+        // when the node gets a new one, and nodes aren't freed before Clear()
+        inline void Check() const {
+            if constexpr (IteratorChecks::kEnabled) {
+                if (current_->generation_ != generation_) {
+                    throw std::logic_error("Iterator to an erased element");
+                }
+            }
+        }
+
+    private:
+        Node* current_;
+        [[no_unique_address]] Generation generation_;
+    };
+
+    inline MapIterator Begin() const noexcept {
+        if (IsEmpty()) {
+            return MapIterator(FakeNode());
+        }
+
+        return MapIterator(Leftmost(Root()));
+    }
+
+    inline MapIterator End() const noexcept {
+        return MapIterator(FakeNode());
+    }
+
+    // Walk over the threads in either direction.
+    // Both directions step in O(1) amortized without a stack
+    template <bool IsReverse, bool IsConst>
+    class ThreadIterator {
+        friend class Map;
+
+    public:
+        // NOLINTNEXTLINE
+        using value_type = std::pair<const Key, Value>;
+        // NOLINTNEXTLINE
+        using reference_type = std::conditional_t<IsConst, const value_type&, value_type&>;
+        // NOLINTNEXTLINE
+        using pointer_type = std::conditional_t<IsConst, const value_type*, value_type*>;
+        // NOLINTNEXTLINE
+        using difference_type = std::ptrdiff_t;
+        // NOLINTNEXTLINE
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        inline bool operator==(const ThreadIterator& other) const {
+            return current_ == other.current_;
+        }
+
+        inline bool operator!=(const ThreadIterator& other) const {
+            return current_ != other.current_;
+        }
+
+        inline reference_type operator*() const {
+            return current_->data_;
+        }
+
+        inline pointer_type operator->() const {
+            return &current_->data_;
+        }
+
+        ThreadIterator& operator++() {
+            current_ = IsReverse ? Prev(current_) : Next(current_);
+            return *this;
+        }
+
+        ThreadIterator operator++(int) {
+            ThreadIterator copy = *this;
+            operator++();
+            return copy;
+        }
+
+        ThreadIterator& operator--() {
+            current_ = IsReverse ? Next(current_) : Prev(current_);
+            return *this;
+        }
+
+        ThreadIterator operator--(int) {
+            ThreadIterator copy = *this;
+            operator--();
+            return copy;
+        }
+
+    private:
+        explicit ThreadIterator(Node* current) : current_(current) {
+        }
+
+    private:
+        Node* current_;
+    };
+
+    using ConstIterator = ThreadIterator<false, true>;
+    using ReverseIterator = ThreadIterator<true, false>;
+    using ConstReverseIterator = ThreadIterator<true, true>;
+
+    // The greatest element; the fake node ends the reverse walk as well
+    inline ReverseIterator RBegin() const noexcept {
+        if (IsEmpty()) {
+            return REnd();
+        }
+        return ReverseIterator(Rightmost(Root()));
+    }
+
+    inline ReverseIterator REnd() const noexcept {
+        return ReverseIterator(FakeNode());
+    }
+
+    // Lazy view of the elements in [first, last): allocates nothing
+    // and touches only the elements it yields
+    template <typename Iterator>
+    class View {
+        friend class Map;
+
+    public:
+        inline Iterator Begin() const noexcept {
+            return first_;
+        }
+
+        inline Iterator End() const noexcept {
+            return last_;
+        }
+
+        inline bool IsEmpty() const noexcept {
+            return first_ == last_;
+        }
+
+        // For range-based for
+        // NOLINTNEXTLINE
+        inline Iterator begin() const noexcept {
+            return first_;
+        }
+
+        // NOLINTNEXTLINE
+        inline Iterator end() const noexcept {
+            return last_;
+        }
+
+    private:
+        View(Iterator first, Iterator last) : first_(first), last_(last) {
+        }
+
+    private:
+        Iterator first_;
+        Iterator last_;
+    };
+
+    using RangeView = View<MapIterator>;
+
+    // All elements in increasing order
+    View<ConstIterator> Ascending() const noexcept {
+        return {ConstIterator(Begin().current_), ConstIterator(FakeNode())};
+    }
+
+    // All elements in decreasing order
+    View<ConstReverseIterator> Descending() const noexcept {
+        return {ConstReverseIterator(RBegin().current_), ConstReverseIterator(FakeNode())};
+    }
+
+    Map() noexcept : sz_(0) {
+        new (fake_node_) Node();
+    }
+
+    Map(const Map&) = delete;
+    Map& operator=(const Map&) = delete;
+
+    // Doesn't allocate: the fake node lives inside the map
+    Map(Map&& other) noexcept : Map() {
+        Swap(other);
+    }
+
+    Map& operator=(Map&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    // Map from pairs sorted by key in O(n), see BulkInsert
+    template <typename InputIt>
+    static Map FromSorted(InputIt first, InputIt last) {
+        Map mp;
+        mp.BulkInsert(first, last);
+        return mp;
+    }
+
+    Value& operator[](const Key& key) {
+        return InsertNode(key).first->data_.second;
+    }
+
+    Value& operator[](Key&& key) {
+        return InsertNode(std::move(key)).first->data_.second;
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return this->sz_ == 0;
+    }
+
+    inline size_t Size() const noexcept {
+        return this->sz_;
+    }
+
+    void Swap(Map& a) noexcept {
+        static_assert(std::is_same<decltype(this->comp_), decltype(a.comp_)>::value,
+                      "The compare function types are different");
+
+        std::swap(this->comp_, a.comp_);
+        std::swap(this->sz_, a.sz_);
+        storage_.Swap(a.storage_);
+        std::swap(this->instrumentation_, a.instrumentation_);
+        std::swap(this->recycled_, a.recycled_);
+
+        // Fake nodes stay in place, the trees are hung on the other ones,
+        // so End() iterators are invalidated
+        Node* root = Root();
+        SetRoot(a.Root());
+        a.SetRoot(root);
+        RethreadEnds();
+        a.RethreadEnds();
+    }
+
+    std::vector<std::pair<const Key, Value>> Values(bool is_increase = true) const {
+        std::vector<std::pair<const Key, Value>> res;
+        res.reserve(this->sz_);
+
+        if (is_increase) {
+            for (const auto& val : Ascending()) {
+                res.push_back(val);
+            }
+        } else {
+            for (const auto& val : Descending()) {
+                res.push_back(val);
+            }
+        }
+        return res;
+    }
+
+    void Insert(const std::pair<const Key, Value>& val) {
+        auto [node, is_inserted] = InsertNode(val.first, val.second);
+        if (!is_inserted) {
+            node->data_.second = val.second;
+        }
+    }
+
+    // The key is const in the pair, so only the value is moved
+    void Insert(std::pair<const Key, Value>&& val) {
+        InsertOrAssign(val.first, std::move(val.second));
+    }
+
+    // Inserts or assigns like Insert; hint is where the element is expected
+    // to go (right before it). A right hint saves the search: End() for runs
+    // of increasing keys, Begin() for decreasing ones, the result of the
+    // previous insertion for keys going one after another.
+    // See InsertNodeHint. A wrong hint only costs an ordinary insertion
+    MapIterator Insert(MapIterator hint, const std::pair<const Key, Value>& val) {
+        hint.Check();
+        auto [node, is_inserted] = InsertNodeHint(hint.current_, val.first, val.second);
+        if (!is_inserted) {
+            node->data_.second = val.second;
+        }
+        return MapIterator(node);
+    }
+
+    MapIterator Insert(MapIterator hint, std::pair<const Key, Value>&& val) {
+        hint.Check();
+        auto [node, is_inserted] = InsertNodeHint(hint.current_, val.first, std::move(val.second));
+        if (!is_inserted) {
+            node->data_.second = std::move(val.second);
+        }
+        return MapIterator(node);
+    }
+
+    // Constructs the value from args only if there is no such key yet:
+    // nothing is copied or moved for an existing key
+    template <typename... Args>
+    std::pair<MapIterator, bool> TryEmplace(const Key& key, Args&&... args) {
+        auto [node, is_inserted] = InsertNode(key, std::forward<Args>(args)...);
+        return {MapIterator(node), is_inserted};
+    }
+
+    template <typename... Args>
+    std::pair<MapIterator, bool> TryEmplace(Key&& key, Args&&... args) {
+        auto [node, is_inserted] = InsertNode(std::move(key), std::forward<Args>(args)...);
+        return {MapIterator(node), is_inserted};
+    }
+
+    // Inserts or assigns in one descent
+    template <typename M>
+    std::pair<MapIterator, bool> InsertOrAssign(const Key& key, M&& value) {
+        auto [node, is_inserted] = InsertNode(key, std::forward<M>(value));
+        if (!is_inserted) {
+            node->data_.second = std::forward<M>(value);
+        }
+        return {MapIterator(node), is_inserted};
+    }
+
+    template <typename M>
+    std::pair<MapIterator, bool> InsertOrAssign(Key&& key, M&& value) {
+        auto [node, is_inserted] = InsertNode(std::move(key), std::forward<M>(value));
+        if (!is_inserted) {
+            node->data_.second = std::forward<M>(value);
+        }
+        return {MapIterator(node), is_inserted};
+    }
+
+    void Insert(const std::initializer_list<std::pair<const Key, Value>>& values) {
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            Insert(*it);
+        }
+    }
+
+    // Inserts pairs sorted by key, equal keys overwrite values like Insert.
+    // The input is merged with the elements in order and a perfectly
+    // balanced tree is rebuilt from the result: O(Size() + n) instead of
+    // O(n log(Size() + n)), and no rotations at all.
+    // Throws std::invalid_argument on unsorted input; pairs before
+    // the violation stay inserted.
+    template <typename InputIt>
+    void BulkInsert(InputIt first, InputIt last) {
+        std::vector<Node*> nodes;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                        typename std::iterator_traits<InputIt>::iterator_category>) {
+            nodes.reserve(sz_ + std::distance(first, last));
+        } else {
+            nodes.reserve(sz_);
+        }
+
+        // Elements of the map not yet moved to nodes
+        Node* curr = IsEmpty() ? FakeNode() : Begin().current_;
+
+        try {
+            for (; first != last; ++first) {
+                const auto& val = *first;
+
+                if (!nodes.empty() && !Less(nodes.back()->data_.first, val.first)) {
+                    if (Less(val.first, nodes.back()->data_.first)) {
+                        throw std::invalid_argument("BulkInsert input is not sorted");
+                    }
+                    nodes.back()->data_.second = val.second;
+                    continue;
+                }
+
+                while (curr != FakeNode() && Less(curr->data_.first, val.first)) {
+                    nodes.push_back(curr);
+                    curr = Next(curr);
+                }
+
+                if (curr != FakeNode() && !Less(val.first, curr->data_.first)) {
+                    curr->data_.second = val.second;
+                    nodes.push_back(curr);
+                    curr = Next(curr);
+                } else {
+                    nodes.push_back(NewNode(val.first, val.second));
+                }
+            }
+        } catch (...) {
+            for (; curr != FakeNode(); curr = Next(curr)) {
+                nodes.push_back(curr);
+            }
+            Build(nodes);
+            throw;
+        }
+
+        for (; curr != FakeNode(); curr = Next(curr)) {
+            nodes.push_back(curr);
+        }
+        Build(nodes);
+    }
+
+    // Moves all elements of other here, equal keys take the value from
+    // other like Insert. Both maps are walked in order in lockstep and the
+    // tree is rebuilt from the result: O(Size() + other.Size()).
+    // Nodes of other are relinked, not copied, if Storage allows it
+    void Merge(Map&& other) {
+        if (this == &other || other.IsEmpty()) {
+            return;
+        }
+
+        std::vector<Node*> nodes;
+        nodes.reserve(sz_ + other.sz_);
+        Node* curr = Next(FakeNode());
+        Node* theirs = Next(other.FakeNode());
+
+        try {
+            while (theirs != other.FakeNode()) {
+                if (curr != FakeNode() && Less(curr->data_.first, theirs->data_.first)) {
+                    nodes.push_back(curr);
+                    curr = Next(curr);
+                    continue;
+                }
+
+                Node* taken = theirs;
+                theirs = Next(theirs);
+                if (curr != FakeNode() && !Less(taken->data_.first, curr->data_.first)) {
+                    curr->data_.second = std::move(taken->data_.second);
+                    nodes.push_back(curr);
+                    curr = Next(curr);
+                    if constexpr (Storage<Node>::kAdoptsNodes) {
+                        other.Retire(taken);
+                    }
+                } else if constexpr (Storage<Node>::kAdoptsNodes) {
+                    nodes.push_back(taken);
+                } else {
+                    nodes.push_back(NewNode(taken->data_.first, std::move(taken->data_.second)));
+                }
+            }
+        } catch (...) {
+            // Only copying can throw: other keeps all its nodes
+            for (; curr != FakeNode(); curr = Next(curr)) {
+                nodes.push_back(curr);
+            }
+            Build(nodes);
+            throw;
+        }
+
+        for (; curr != FakeNode(); curr = Next(curr)) {
+            nodes.push_back(curr);
+        }
+        Build(nodes);
+
+        if constexpr (Storage<Node>::kAdoptsNodes) {
+            other.sz_ = 0;
+            other.SetRoot(nullptr);
+        } else {
+            other.Clear();
+        }
+    }
+
+    // Set operations below copy elements to a new map in O(Size() + other.Size())
+
+    // Elements of both maps, equal keys take the value from other like Merge
+    Map Union(const Map& other) const {
+        return Combine<true, true, true>(other);
+    }
+
+    // Elements with keys present in both maps, values are from this map
+    Map Intersect(const Map& other) const {
+        return Combine<false, false, true>(other);
+    }
+
+    // Elements with keys absent in other
+    Map Difference(const Map& other) const {
+        return Combine<true, false, false>(other);
+    }
+
+    void Erase(const Key& key) {
+        EraseKey(key);
+    }
+
+    template <detail::map::TransparentKey<Compare, Key> K>
+        requires(!std::is_same_v<K, MapIterator>)
+    void Erase(const K& key) {
+        EraseKey(key);
+    }
+
+    // Erases the element pos points to and returns the iterator to the next one.
+    // There is no key search: the descent for the rebalancing path needs one
+    // comparison per level and recognizes the node by its address
+    MapIterator Erase(MapIterator pos) {
+        pos.Check();
+        Node* target = pos.current_;
+        if (target == FakeNode()) {
+            throw std::runtime_error("Value not found");
+        }
+        Node* next = Next(target);
+
+        Path path;
+        path.Push(FakeNode());
+
+        Node* curr = Root();
+        instrumentation_.OnLookup();
+        while (curr != target) {
+            if (curr == nullptr) {
+                throw std::invalid_argument("Iterator of another map");
+            }
+            instrumentation_.OnVisit();
+            path.Push(curr);
+            curr = Less(target->data_.first, curr->data_.first) ? LeftChild(curr) : RightChild(curr);
+        }
+        instrumentation_.OnVisit();
+
+        EraseNode(path, curr);
+        return MapIterator(next);
+    }
+
+    void Clear() noexcept {
+        FreeRecycled();
+
+        if (IsEmpty()) {
+            // Erased elements may still hold slabs
+        } else if constexpr (Storage<Node>::kReleasesAll && std::is_trivially_destructible_v<std::pair<const Key, Value>>) {
+            // Nothing to destroy: slabs go back as a whole
+            sz_ = 0;
+        } else {
+            Del();
+        }
+        storage_.Release();
+        SetRoot(nullptr);
+    }
+
+    // Lookups below also take any K comparable with Key if Compare is
+    // transparent: Map<std::string, V, std::less<>> is searched by
+    // std::string_view or const char* without allocating a std::string
+    MapIterator Find(const Key& key) const {
+        return MapIterator(FindNode(key));
+    }
+
+    template <detail::map::TransparentKey<Compare, Key> K>
+    MapIterator Find(const K& key) const {
+        return MapIterator(FindNode(key));
+    }
+
+    bool Contains(const Key& key) const {
+        return FindNode(key) != FakeNode();
+    }
+
+    template <detail::map::TransparentKey<Compare, Key> K>
+    bool Contains(const K& key) const {
+        return FindNode(key) != FakeNode();
+    }
+
+    // First element whose key is not less than key, or End()
+    MapIterator LowerBound(const Key& key) const {
+        return MapIterator(LowerBoundNode(key));
+    }
+
+    template <detail::map::TransparentKey<Compare, Key> K>
+    MapIterator LowerBound(const K& key) const {
+        return MapIterator(LowerBoundNode(key));
+    }
+
+    // First element whose key is greater than key, or End()
+    MapIterator UpperBound(const Key& key) const {
+        return MapIterator(UpperBoundNode(key));
+    }
+
+    template <detail::map::TransparentKey<Compare, Key> K>
+    MapIterator UpperBound(const K& key) const {
+        return MapIterator(UpperBoundNode(key));
+    }
+
+    // Elements with a key equivalent to key: at most one
+    std::pair<MapIterator, MapIterator> EqualRange(const Key& key) const {
+        return EqualRangeNodes(key);
+    }
+
+    template <detail::map::TransparentKey<Compare, Key> K>
+    std::pair<MapIterator, MapIterator> EqualRange(const K& key) const {
+        return EqualRangeNodes(key);
+    }
 
-public:
-    class MapIterator {
+    // Number of elements with a key less than key
+    size_t Rank(const Key& key) const {
+        size_t rank = 0;
+        Node* temp = Root();
+        instrumentation_.OnLookup();
+
+        while (temp != nullptr) {
+            instrumentation_.OnVisit();
+            if (Less(temp->data_.first, key)) {
+                rank += SubtreeSize(LeftChild(temp)) + 1;
+                temp = RightChild(temp);
+            } else {
+                temp = LeftChild(temp);
+            }
+        }
+
+        return rank;
+    }
+
+    // Element with index k in increasing order (0-based), or End() if k >= Size()
+    MapIterator Select(size_t k) const {
+        if (k >= sz_) {
+            return End();
+        }
+
+        Node* temp = Root();
+        instrumentation_.OnLookup();
+        while (true) {
+            instrumentation_.OnVisit();
+            size_t left_size = SubtreeSize(LeftChild(temp));
+            if (k < left_size) {
+                temp = LeftChild(temp);
+            } else if (k == left_size) {
+                return MapIterator(temp);
+            } else {
+                k -= left_size + 1;
+                temp = RightChild(temp);
+            }
+        }
+    }
+
+    // Number of elements with lo <= key < hi
+    size_t CountInRange(const Key& lo, const Key& hi) const {
+        if (!Less(lo, hi)) {
+            return 0;
+        }
+        return Rank(hi) - Rank(lo);
+    }
+
+    // Elements with lo <= key < hi
+    RangeView Range(const Key& lo, const Key& hi) const {
+        MapIterator first = LowerBound(lo);
+        if (first == End() || !Less(first->first, hi)) {
+            return RangeView(first, first);
+        }
+        return RangeView(first, LowerBound(hi));
+    }
+
+    // Counters of the Instrumentation policy, empty for NoInstrumentation
+    MapStats Stats() const noexcept {
+        return instrumentation_.Stats();
+    }
+
+    void ResetStats() noexcept {
+        instrumentation_.Reset();
+    }
+
+    ~Map() {
+        Clear();
+    }
+
+private:
+    class Node {
+        friend class MapIterator;
         friend class Map;
 
-    public:
-        // NOLINTNEXTLINE
-        using value_type = std::pair<const Key, Value>;
-        // NOLINTNEXTLINE
-        using reference_type = value_type&;
-        // NOLINTNEXTLINE
-        using pointer_type = value_type*;
-        // NOLINTNEXTLINE
-        using difference_type = std::ptrdiff_t;
-        // NOLINTNEXTLINE
-        using iterator_category = std::forward_iterator_tag;
+        // Nodes are aligned at least to 8 bytes, so the lowest bit of a link
+        // is free and tells a thread from a child
+        static constexpr uintptr_t kLinkBit = 1;
+        // Height takes the highest byte of the size word
+        static constexpr int kSizeBits = 56;
+        static constexpr uint64_t kSizeMask = (uint64_t{1} << kSizeBits) - 1;
+        static constexpr uint64_t kLeafHeightSize = (uint64_t{1} << kSizeBits) | 1;
 
-        inline bool operator==(const MapIterator& other) const {
-            return this->current_ == other.current_;
+    private:
+        uintptr_t left_;
+        uintptr_t right_;
+        // Height of the subtree (1 for a leaf) and number of nodes in it
+        uint64_t height_size_ = kLeafHeightSize;
+        // Even while the node holds an element, odd after it's erased
+        [[no_unique_address]] Generation generation_{};
+        // The fake node has no element: data_ lives only in real nodes and is
+        // destroyed by the map, see DeleteNode
+        union {
+            std::pair<const Key, Value> data_;
         };
 
-        inline bool operator!=(const MapIterator& other) const {
-            return this->current_ != other.current_;
-        };
+    public:
+        // Value is constructed in place from args, Value() if there are none
+        template <typename K, typename... Args>
+        explicit Node(K&& key, Args&&... args)
+            : left_(0),
+              right_(0),
+              data_(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                    std::forward_as_tuple(std::forward<Args>(args)...)) {
+        }
+        // Fake node of an empty map: its right thread loops to itself
+        explicit Node() noexcept : left_(0), right_(reinterpret_cast<uintptr_t>(this) | kLinkBit) {
+        }
 
-        inline reference_type operator*() const {
-            return this->current_->data_;
-        };
+        ~Node() {
+        }
 
-        MapIterator& operator++() {
+        // Gives an erased node a new element, see Map::NewNode. If the
+        // element throws, the node stays erased
+        template <typename K, typename... Args>
+        void Revive(K&& key, Args&&... args) {
+            std::construct_at(&data_, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+            left_ = 0;
+            right_ = 0;
+            height_size_ = kLeafHeightSize;
+            ++generation_;
+        }
 
-            if (this->current_->is_right_link_) {
-                this->current_ = this->current_->right_;
-            } else {
-                this->current_ = this->current_->right_;
+        inline Node* Left() const noexcept {
+            return reinterpret_cast<Node*>(left_ & ~kLinkBit);
+        }
 
-                while (this->current_->left_ != nullptr) {
-                    this->current_ = this->current_->left_;
-                }
-            }
+        inline Node* Right() const noexcept {
+            return reinterpret_cast<Node*>(right_ & ~kLinkBit);
+        }
 
-            return *this;
-        };
+        inline bool IsLeftLink() const noexcept {
+            return (left_ & kLinkBit) != 0;
+        }
 
-        MapIterator operator++(int) {
-            MapIterator copy = *this;
-            operator++();
-            return copy;
-        };
+        inline bool IsRightLink() const noexcept {
+            return (right_ & kLinkBit) != 0;
+        }
 
-        inline pointer_type operator->() const {
-            return &current_->data_;
-        };
+        // Setters of a link keep its flag and vice versa
+        inline void SetLeft(Node* node) noexcept {
+            left_ = reinterpret_cast<uintptr_t>(node) | (left_ & kLinkBit);
+        }
 
-    private:
-        explicit MapIterator(Node* current) : current_(current) {
+        inline void SetRight(Node* node) noexcept {
+            right_ = reinterpret_cast<uintptr_t>(node) | (right_ & kLinkBit);
         }
 
-    private:
-        Node* current_;
-    };
+        inline void SetLeftLink(bool is_link) noexcept {
+            left_ = (left_ & ~kLinkBit) | static_cast<uintptr_t>(is_link);
+        }
 
-    inline MapIterator Begin() const noexcept {
-        if (IsEmpty()) {
-            return MapIterator(this->fake_node_);
+        inline void SetRightLink(bool is_link) noexcept {
+            right_ = (right_ & ~kLinkBit) | static_cast<uintptr_t>(is_link);
+        }
+
+        inline int GetHeight() const noexcept {
+            return static_cast<int>(height_size_ >> kSizeBits);
         }
 
-        Node* temp = this->root_;
+        inline void SetHeight(int height) noexcept {
+            height_size_ = (height_size_ & kSizeMask) | (static_cast<uint64_t>(height) << kSizeBits);
+        }
+
+        inline size_t GetSize() const noexcept {
+            return height_size_ & kSizeMask;
+        }
+
+        inline void SetSize(size_t size) noexcept {
+            height_size_ = (height_size_ & ~kSizeMask) | size;
+        }
+    };
+
+    static_assert(alignof(Node) > Node::kLinkBit, "The lowest bit of a node address must be free");
+
+    // Nodes from the fake node to the current one.
+    // Nodes don't know their parents, so rebalancing goes back along the path
+    struct Path {
+        std::array<Node*, kMaxHeight + 1> nodes;
+        size_t size = 0;
 
-        while (temp->left_ != nullptr) {
-            temp = temp->left_;
+        inline void Push(Node* node) noexcept {
+            nodes[size++] = node;
         }
 
-        return MapIterator(temp);
+        inline Node* Top() const noexcept {
+            return nodes[size - 1];
+        }
+    };
+
+    // The fake node is the parent of the root from both sides. It closes
+    // the ring of threads: Next(End()) is the first element, Prev(End()) the last
+    // Const methods hand out the fake node as End(), only non-const ones change it
+    inline Node* FakeNode() const noexcept {
+        return std::launder(reinterpret_cast<Node*>(const_cast<std::byte*>(fake_node_)));
     }
 
-    inline MapIterator End() const noexcept {
-        return MapIterator(this->fake_node_);
+    inline Node* Root() const noexcept {
+        return FakeNode()->Left();
     }
 
-    Map() : root_(nullptr), sz_(0) {
-        this->fake_node_ = new Node();
+    void SetRoot(Node* root) noexcept {
+        Node* fake = FakeNode();
+        fake->SetLeft(root);
+        fake->SetRightLink(root == nullptr);
+        fake->SetRight((root == nullptr) ? fake : root);
     }
 
-    Value& operator[](const Key& key) {
-        if (IsEmpty()) {
-            this->root_ = new Node(key);
-            this->fake_node_->left_ = this->root_;
-            this->root_->is_right_link_ = true;
-            this->root_->right_ = this->fake_node_;
-            ++sz_;
-            return this->root_->data_.second;
+    // Points the outer threads of the first and the last nodes to the fake
+    // node of this map, O(log n)
+    void RethreadEnds() noexcept {
+        Node* root = Root();
+        if (root != nullptr) {
+            Leftmost(root)->SetLeft(FakeNode());
+            Rightmost(root)->SetRight(FakeNode());
         }
+    }
 
-        Node* temp = this->root_;
+    static inline Node* LeftChild(Node* node) noexcept {
+        return node->IsLeftLink() ? nullptr : node->Left();
+    }
 
-        while (true) {
-            if (comp_(key, temp->data_.first)) {
-                if (temp->left_ == nullptr) {
-                    temp->left_ = new Node(key);
-                    temp->left_->is_right_link_ = true;
-                    temp->left_->right_ = temp;
-                    ++sz_;
-                    return temp->left_->data_.second;
-                }
-                temp = temp->left_;
+    static inline Node* RightChild(Node* node) noexcept {
+        return node->IsRightLink() ? nullptr : node->Right();
+    }
 
-            } else if (key == temp->data_.first) {
-                return temp->data_.second;
-            } else {
-                if (temp->is_right_link_) {
-                    Node* ptr = new Node(key);
-                    temp->is_right_link_ = false;
-                    ptr->is_right_link_ = true;
-                    ptr->right_ = temp->right_;
-                    temp->right_ = ptr;
-                    ++sz_;
-                    return ptr->data_.second;
-                }
-                temp = temp->right_;
-            }
+    static inline Node* Leftmost(Node* node) noexcept {
+        while (!node->IsLeftLink()) {
+            node = node->Left();
         }
+        return node;
     }
 
-    inline bool IsEmpty() const noexcept {
-        return this->sz_ == 0;
+    static inline Node* Rightmost(Node* node) noexcept {
+        while (!node->IsRightLink()) {
+            node = node->Right();
+        }
+        return node;
     }
 
-    inline size_t Size() const noexcept {
-        return this->sz_;
+    // In-order successor: the thread, or the leftmost node of the right subtree
+    static inline Node* Next(Node* node) noexcept {
+        return node->IsRightLink() ? node->Right() : Leftmost(node->Right());
     }
 
-    void Swap(Map& a) {
-        static_assert(std::is_same<decltype(this->comp_), decltype(a.comp_)>::value,
-                      "The compare function types are different");
+    // In-order predecessor
+    static inline Node* Prev(Node* node) noexcept {
+        return node->IsLeftLink() ? node->Left() : Rightmost(node->Left());
+    }
 
-        std::swap(this->comp_, a.comp_);
-        std::swap(this->root_, a.root_);
-        std::swap(this->sz_, a.sz_);
-        std::swap(this->fake_node_, a.fake_node_);
+    static inline int Height(Node* node) noexcept {
+        return node == nullptr ? 0 : node->GetHeight();
     }
 
-    std::vector<std::pair<const Key, Value>> Values(bool is_increase = true) const noexcept {
-        std::vector<std::pair<const Key, Value>> res;
+    static inline size_t SubtreeSize(Node* node) noexcept {
+        return node == nullptr ? 0 : node->GetSize();
+    }
 
-        if (IsEmpty()) {
-            return res;
-        }
+    // Recomputes height and size of node from its children
+    static inline void Update(Node* node) noexcept {
+        node->SetHeight(std::max(Height(LeftChild(node)), Height(RightChild(node))) + 1);
+        node->SetSize(SubtreeSize(LeftChild(node)) + SubtreeSize(RightChild(node)) + 1);
+    }
 
-        if (is_increase) {
-            LKP(this->root_, res);
-        } else {
-            PKL(this->root_, res);
+    // Both links are checked for the fake node, which has the root on both sides.
+    // A real node can't have a child on one side and a thread to it on the other
+    static void Replace(Node* parent, Node* old_child, Node* new_child) noexcept {
+        if (parent->Left() == old_child) {
+            parent->SetLeft(new_child);
+        }
+        if (parent->Right() == old_child) {
+            parent->SetRight(new_child);
         }
-        return res;
     }
 
-    void Insert(const std::pair<const Key, Value>& val) {
-        if (IsEmpty()) {
-            this->root_ = new Node(val.first, val.second);
-            this->fake_node_->left_ = this->root_;
-            this->root_->is_right_link_ = true;
-            this->root_->right_ = this->fake_node_;
-            ++sz_;
-            return;
+    // Left child becomes the root of the subtree.
+    // If it had no right subtree, its thread pointed to node and becomes
+    // a real link, while node gets a left thread to it instead
+    static Node* RotateRight(Node* node) noexcept {
+        Node* left = node->Left();
+
+        if (left->IsRightLink()) {
+            node->SetLeftLink(true);
+            left->SetRightLink(false);
+        } else {
+            node->SetLeft(left->Right());
         }
+        left->SetRight(node);
 
-        Node* temp = this->root_;
+        Update(node);
+        Update(left);
+        return left;
+    }
 
-        while (true) {
-            if (comp_(val.first, temp->data_.first)) {
-                if (temp->left_ == nullptr) {
-                    temp->left_ = new Node(val.first, val.second);
-                    temp->left_->is_right_link_ = true;
-                    temp->left_->right_ = temp;
-                    ++sz_;
-                    return;
-                }
-                temp = temp->left_;
+    // Mirror of RotateRight
+    static Node* RotateLeft(Node* node) noexcept {
+        Node* right = node->Right();
 
-            } else if (!comp_(val.first, temp->data_.first) and !comp_(temp->data_.first, val.first)) {
-                temp->data_.second = val.second;
-                return;
-            } else {
-                if (temp->is_right_link_) {
+        if (right->IsLeftLink()) {
+            node->SetRightLink(true);
+            right->SetLeftLink(false);
+        } else {
+            node->SetRight(right->Left());
+        }
+        right->SetLeft(node);
 
-                    Node* ptr = new Node(val.first, val.second);
-                    temp->is_right_link_ = false;
-                    ptr->is_right_link_ = true;
-                    ptr->right_ = temp->right_;
-                    temp->right_ = ptr;
+        Update(node);
+        Update(right);
+        return right;
+    }
 
-                    ++sz_;
-                    return;
-                }
-                temp = temp->right_;
+    // Restores |height(left) - height(right)| <= 1, returns the new root of the subtree
+    Node* Balance(Node* node) noexcept {
+        int balance = Height(LeftChild(node)) - Height(RightChild(node));
+
+        if (balance > 1) {
+            Node* left = node->Left();
+            if (Height(LeftChild(left)) < Height(RightChild(left))) {
+                instrumentation_.OnRotation();
+                node->SetLeft(RotateLeft(left));
             }
+            instrumentation_.OnRotation();
+            return RotateRight(node);
         }
-    }
 
-    void Insert(const std::initializer_list<std::pair<const Key, Value>>& values) {
-        for (auto it = values.begin(); it != values.end(); ++it) {
-            Insert(*it);
+        if (balance < -1) {
+            Node* right = node->Right();
+            if (Height(RightChild(right)) < Height(LeftChild(right))) {
+                instrumentation_.OnRotation();
+                node->SetRight(RotateRight(right));
+            }
+            instrumentation_.OnRotation();
+            return RotateLeft(node);
         }
+
+        Update(node);
+        return node;
     }
 
-    void Erase(const Key& key) {
-        if (IsEmpty()) {
-            throw filesystem::exceptions::TreeIsEmptyException("TreeIsEmpty");
-        }
+    // Goes up the path after an insertion or an erasure, subtree sizes on
+    // the path are already updated. Stops as soon as a subtree keeps its
+    // height: nodes above stay balanced
+    void Rebalance(Path& path) noexcept {
+        for (size_t i = path.size - 1; i > 0; --i) {
+            Node* node = path.nodes[i];
+            int old_height = node->GetHeight();
+
+            Node* balanced = Balance(node);
+            if (balanced != node) {
+                Replace(path.nodes[i - 1], node, balanced);
+            }
 
-        Node* prev = this->root_;
-        Node* curr = this->root_;
+            if (balanced->GetHeight() == old_height) {
+                break;
+            }
+        }
+    }
 
-        while (curr->data_.first != key) {
+    // Makes sorted nodes a perfectly balanced tree: subtree sizes differ by
+    // at most one, so heights do too and the AVL invariant holds
+    void Build(const std::vector<Node*>& nodes) noexcept {
+        sz_ = nodes.size();
+        SetRoot(nodes.empty() ? nullptr : BuildSubtree(nodes, 0, nodes.size(), FakeNode(), FakeNode()));
+    }
 
-            if (comp_(key, curr->data_.first)) {
-                if (curr->left_ == nullptr) {
-                    throw filesystem::exceptions::TreeIsEmptyException("TreeIsEmpty");
+    // Walks both maps in order in lockstep and copies the elements that are
+    // only here, only in other or in both, as the flags say
+    template <bool kTakeOnlyHere, bool kTakeOnlyThere, bool kTakeBoth>
+    Map Combine(const Map& other) const {
+        Map res;
+        res.comp_ = comp_;
+
+        std::vector<Node*> nodes;
+        nodes.reserve((kTakeOnlyHere || kTakeBoth ? sz_ : 0) + (kTakeOnlyThere ? other.sz_ : 0));
+        Node* mine = Next(FakeNode());
+        Node* theirs = Next(other.FakeNode());
+
+        try {
+            while (true) {
+                bool is_mine_over = mine == FakeNode();
+                bool is_theirs_over = theirs == other.FakeNode();
+                // The rest of one map alone can't give anything
+                if ((is_mine_over || !kTakeOnlyHere) && (is_theirs_over || !kTakeOnlyThere) &&
+                    (is_mine_over || is_theirs_over)) {
+                    break;
                 }
-                prev = curr;
-                curr = curr->left_;
 
-            } else {
-                if (curr->is_right_link_) {
-                    throw filesystem::exceptions::TreeIsEmptyException("TreeIsEmpty");
+                if (is_theirs_over || (!is_mine_over && Less(mine->data_.first, theirs->data_.first))) {
+                    if constexpr (kTakeOnlyHere) {
+                        nodes.push_back(res.NewNode(mine->data_.first, mine->data_.second));
+                    }
+                    mine = Next(mine);
+                } else if (is_mine_over || Less(theirs->data_.first, mine->data_.first)) {
+                    if constexpr (kTakeOnlyThere) {
+                        nodes.push_back(res.NewNode(theirs->data_.first, theirs->data_.second));
+                    }
+                    theirs = Next(theirs);
+                } else {
+                    if constexpr (kTakeBoth) {
+                        const Value& value = kTakeOnlyThere ? theirs->data_.second : mine->data_.second;
+                        nodes.push_back(res.NewNode(mine->data_.first, value));
+                    }
+                    mine = Next(mine);
+                    theirs = Next(theirs);
                 }
-                prev = curr;
-                curr = curr->right_;
             }
+        } catch (...) {
+            // res frees the copies made so far
+            res.Build(nodes);
+            throw;
         }
 
-        --sz_;
+        res.Build(nodes);
+        return res;
+    }
 
-        if ((curr->is_right_link_) and (curr->left_ == nullptr)) {
+    // Subtree of nodes[lo, hi), prev and next are its in-order neighbours:
+    // outer threads of the subtree point to them
+    static Node* BuildSubtree(const std::vector<Node*>& nodes, size_t lo, size_t hi, Node* prev,
+                              Node* next) noexcept {
+        size_t mid = lo + (hi - lo) / 2;
+        Node* node = nodes[mid];
 
-            if (prev->left_ == curr) {
-                prev->left_ = nullptr;
-            } else {
-                prev->is_right_link_ = true;
-                prev->right_ = curr->right_;
-            }
+        node->SetLeftLink(lo == mid);
+        node->SetLeft((lo == mid) ? prev : BuildSubtree(nodes, lo, mid, prev, node));
+        node->SetRightLink(mid + 1 == hi);
+        node->SetRight((mid + 1 == hi) ? next : BuildSubtree(nodes, mid + 1, hi, node, next));
+
+        Update(node);
+        return node;
+    }
+
+    // All key comparisons and allocations go through Less and NewNode,
+    // Instrumentation counts them there
 
-            if (curr == this->root_) {
-                this->fake_node_->left_ = nullptr;
-                this->root_ = nullptr;
+    template <typename A, typename B>
+    inline bool Less(const A& lhs, const B& rhs) const {
+        instrumentation_.OnCompare();
+        return comp_(lhs, rhs);
+    }
+
+    template <typename... Args>
+    inline Node* NewNode(Args&&... args) {
+        Node* node;
+        if constexpr (IteratorChecks::kEnabled) {
+            if (recycled_ != nullptr) {
+                node = recycled_;
+                Node* next = node->Left();
+                node->Revive(std::forward<Args>(args)...);
+                recycled_ = next;
+                instrumentation_.OnAllocate();
+                return node;
             }
-            delete curr;
-            return;
+        }
+        node = storage_.New(std::forward<Args>(args)...);
+        instrumentation_.OnAllocate();
+        return node;
+    }
+
+    // Erased nodes are deleted at once. With CheckedIterators they go to
+    // the list of recycled nodes instead and are reused by NewNode: memory
+    // doesn't grow beyond the largest size of the map, and stale iterators
+    // to any former element of a node are caught by its generation
+    void Retire(Node* node) noexcept {
+        if constexpr (IteratorChecks::kEnabled) {
+            std::destroy_at(&node->data_);
+            ++node->generation_;
+            node->left_ = reinterpret_cast<uintptr_t>(recycled_);
+            recycled_ = node;
+        } else {
+            DeleteNode(node);
+        }
+    }
 
-        } else if ((curr->is_right_link_) and (curr->left_ != nullptr)) {
+    inline void DeleteNode(Node* node) noexcept {
+        std::destroy_at(&node->data_);
+        storage_.Delete(node);
+    }
 
-            Node* temp = curr->left_;
+    // Elements of recycled nodes are already destroyed
+    void FreeRecycled() noexcept {
+        while (recycled_ != nullptr) {
+            Node* next = recycled_->Left();
+            storage_.Delete(recycled_);
+            recycled_ = next;
+        }
+    }
 
-            while (!temp->is_right_link_) {
-                temp = temp->right_;
+    template <typename K>
+    Node* FindNode(const K& key) const {
+        Node* temp = Root();
+        instrumentation_.OnLookup();
+
+        while (temp != nullptr) {
+            instrumentation_.OnVisit();
+            if (Less(key, temp->data_.first)) {
+                temp = LeftChild(temp);
+            } else if (Less(temp->data_.first, key)) {
+                temp = RightChild(temp);
+            } else {
+                return temp;
             }
-            temp->right_ = this->fake_node_;
+        }
+
+        return FakeNode();
+    }
 
-            if (curr == this->root_) {
-                this->fake_node_->left_ = curr->left_;
-                this->root_ = curr->left_;
+    template <typename K>
+    Node* LowerBoundNode(const K& key) const {
+        Node* result = FakeNode();
+        Node* temp = Root();
+        instrumentation_.OnLookup();
+
+        while (temp != nullptr) {
+            instrumentation_.OnVisit();
+            if (Less(temp->data_.first, key)) {
+                temp = RightChild(temp);
+            } else {
+                result = temp;
+                temp = LeftChild(temp);
             }
+        }
+
+        return result;
+    }
 
-            if (prev->left_ == curr) {
-                prev->left_ = curr->left_;
+    template <typename K>
+    Node* UpperBoundNode(const K& key) const {
+        Node* result = FakeNode();
+        Node* temp = Root();
+        instrumentation_.OnLookup();
+
+        while (temp != nullptr) {
+            instrumentation_.OnVisit();
+            if (Less(key, temp->data_.first)) {
+                result = temp;
+                temp = LeftChild(temp);
             } else {
-                prev->right_ = curr->left_;
+                temp = RightChild(temp);
             }
+        }
 
-            delete curr;
-            return;
+        return result;
+    }
 
-        } else if ((!curr->is_right_link_) and (curr->left_ != nullptr)) {
+    template <typename K>
+    std::pair<MapIterator, MapIterator> EqualRangeNodes(const K& key) const {
+        MapIterator first(LowerBoundNode(key));
+        if (first == End() || Less(key, first->first)) {
+            return {first, first};
+        }
 
-            Node* temp = curr->right_;
-            Node* t_prev = curr;
+        MapIterator last = first;
+        return {first, ++last};
+    }
 
-            while (temp->left_ != nullptr) {
-                t_prev = temp;
-                temp = temp->left_;
-            }
+    template <typename K>
+    void EraseKey(const K& key) {
+        Path path;
+        path.Push(FakeNode());
 
-            Node* it = curr->left_;
-
-            if ((temp->is_right_link_) and (temp->left_ == nullptr)) {
-                temp->left_ = curr->left_;
-                temp->right_ = (t_prev == curr) ? this->fake_node_ : curr->right_;
-                temp->is_right_link_ = (t_prev == curr);
-                t_prev->left_ = nullptr;
-            } else if (!(temp->is_right_link_) and (temp->left_ == nullptr)) {
-                temp->left_ = curr->left_;
-                if (t_prev != curr) {
-                    t_prev->left_ = temp->right_;
-                    temp->right_ = curr->right_;
-                }
+        Node* curr = Root();
+        instrumentation_.OnLookup();
+        while (true) {
+            if (curr == nullptr) {
+                throw std::runtime_error("Value not found");
             }
-
-            while (!it->is_right_link_) {
-                it = it->right_;
+            instrumentation_.OnVisit();
+
+            if (Less(key, curr->data_.first)) {
+                path.Push(curr);
+                curr = LeftChild(curr);
+            } else if (Less(curr->data_.first, key)) {
+                path.Push(curr);
+                curr = RightChild(curr);
+            } else {
+                break;
             }
-            it->right_ = temp;
+        }
 
-            if (curr == this->root_) {
-                this->root_ = temp;
-                this->fake_node_->left_ = temp;
+        EraseNode(path, curr);
+    }
+
+    // Unlinks curr, path goes from the fake node to its parent
+    void EraseNode(Path& path, Node* curr) noexcept {
+        Node* parent = path.Top();
+
+        if (!curr->IsLeftLink() and !curr->IsRightLink()) {
+            // The successor (leftmost node of the right subtree) takes the place of curr.
+            // Nodes are relinked instead of moving data: the key is const
+            // and iterators to other elements stay valid
+            size_t curr_index = path.size;
+            path.Push(curr);
+
+            Node* succ_parent = curr;
+            Node* succ = curr->Right();
+            while (!succ->IsLeftLink()) {
+                path.Push(succ);
+                succ_parent = succ;
+                succ = succ->Left();
             }
 
-            if (prev->left_ == curr) {
-                prev->left_ = curr;
-            } else {
-                prev->right_ = temp;
+            if (succ_parent != curr) {
+                if (succ->IsRightLink()) {
+                    // succ_parent loses its left subtree: succ precedes it now
+                    succ_parent->SetLeftLink(true);
+                    succ_parent->SetLeft(succ);
+                } else {
+                    succ_parent->SetLeft(succ->Right());
+                }
+                succ->SetRight(curr->Right());
+                succ->SetRightLink(false);
             }
+            succ->SetLeft(curr->Left());
+            succ->SetLeftLink(false);
+            succ->SetHeight(curr->GetHeight());
+            succ->SetSize(curr->GetSize());
 
-            delete curr;
-            return;
+            // The predecessor of curr was threaded to it
+            Rightmost(curr->Left())->SetRight(succ);
 
-        } else if ((!curr->is_right_link_) and (curr->left_ == nullptr)) {
+            Replace(parent, curr, succ);
+            path.nodes[curr_index] = succ;
 
-            if (curr == this->root_) {
-                this->root_ = curr->right_;
-                this->fake_node_->left_ = curr->right_;
-            }
+        } else if (!curr->IsLeftLink()) {
+            Rightmost(curr->Left())->SetRight(curr->Right());
+            Replace(parent, curr, curr->Left());
 
-            if (prev->left_ == curr) {
-                prev->left_ = curr->right_;
-            } else {
-                prev->is_right_link_ = curr->is_right_link_;
-                prev->right_ = curr->right_;
-            }
+        } else if (!curr->IsRightLink()) {
+            Leftmost(curr->Right())->SetLeft(curr->Left());
+            Replace(parent, curr, curr->Right());
 
-            delete curr;
-            return;
-        }
-    }
+        } else if (parent == FakeNode()) {
+            // The only element
+            SetRoot(nullptr);
 
-    void Clear() noexcept {
+        } else if (parent->Left() == curr) {
+            // Left leaf: the parent gets its thread
+            parent->SetLeftLink(true);
+            parent->SetLeft(curr->Left());
 
-        if (IsEmpty()) {
-            return;
+        } else {
+            parent->SetRightLink(true);
+            parent->SetRight(curr->Right());
         }
 
-        Del();
+        Retire(curr);
+        --sz_;
+        // Sizes change up to the root, unlike heights
+        for (size_t i = 1; i < path.size; ++i) {
+            path.nodes[i]->SetSize(path.nodes[i]->GetSize() - 1);
+        }
+        Rebalance(path);
     }
 
-    MapIterator Find(const Key& key) const {
-
+    // Returns the node with an equivalent key and whether it was just created.
+    // The value is constructed from args only if the key is new
+    template <typename K, typename... Args>
+    std::pair<Node*, bool> InsertNode(K&& key, Args&&... args) {
+        instrumentation_.OnLookup();
         if (IsEmpty()) {
-            return MapIterator(this->fake_node_);
+            Node* node = NewNode(std::forward<K>(key), std::forward<Args>(args)...);
+            node->SetLeftLink(true);
+            node->SetLeft(FakeNode());
+            node->SetRightLink(true);
+            node->SetRight(FakeNode());
+            SetRoot(node);
+            ++sz_;
+            return {node, true};
         }
 
-        Node* temp = this->root_;
+        Path path;
+        path.Push(FakeNode());
 
-        while (true) {
+        Node* temp = Root();
 
-            if (temp->data_.first == key) {
-                return MapIterator(temp);
-            }
+        while (true) {
+            path.Push(temp);
+            instrumentation_.OnVisit();
 
-            if (comp_(temp->data_.first, temp->data_.first)) {
-                if (temp->left_ == nullptr) {
-                    return MapIterator(this->fake_node_);
+            if (Less(key, temp->data_.first)) {
+                if (temp->IsLeftLink()) {
+                    return {AttachLeft(path, std::forward<K>(key), std::forward<Args>(args)...), true};
                 }
-                temp = temp->left_;
-            } else {
+                temp = temp->Left();
 
-                if (temp->is_right_link_) {
-                    return MapIterator(this->fake_node_);
+            } else if (Less(temp->data_.first, key)) {
+                if (temp->IsRightLink()) {
+                    return {AttachRight(path, std::forward<K>(key), std::forward<Args>(args)...), true};
                 }
-                temp = temp->right_;
+                temp = temp->Right();
+
+            } else {
+                return {temp, false};
             }
         }
     }
 
-    ~Map() {
-        Clear();
-        delete fake_node_;
-    }
-
-private:
-    class Node {
-        friend class MapIterator;
-        friend class Map;
-
-    private:
-        bool is_right_link_;
-        Node* left_;
-        Node* right_;
-        std::pair<const Key, Value> data_;
-
-    public:
-        explicit Node(const Key& key, const Value& value)
-            : is_right_link_(false), left_(nullptr), right_(nullptr), data_(std::make_pair(key, value)) {
+    // Insertion right before hint. The hint is right if the key is between
+    // Prev(hint) and hint: the threads give both, so it takes two comparisons.
+    // The new node then takes the left thread of hint or the right thread
+    // of the predecessor, whichever is free.
+    // Nodes don't know their parents and every insertion updates sizes up
+    // to the root, so the path is still collected from the root. Before End() and
+    // Begin() it is the right or the left spine and costs no comparisons:
+    // appends of increasing keys cost one. Elsewhere the key is known to be
+    // new, so a level costs one comparison instead of two.
+    // A wrong hint is an ordinary InsertNode
+    template <typename K, typename... Args>
+    std::pair<Node*, bool> InsertNodeHint(Node* hint, K&& key, Args&&... args) {
+        if (IsEmpty()) {
+            return InsertNode(std::forward<K>(key), std::forward<Args>(args)...);
         }
-        explicit Node(const Key& key)
-            : is_right_link_(false), left_(nullptr), right_(nullptr), data_(std::make_pair(key, Value{})) {
+
+        instrumentation_.OnLookup();
+        Path path;
+        path.Push(FakeNode());
+        Node* temp = Root();
+        path.Push(temp);
+        instrumentation_.OnVisit();
+
+        // Before End() the predecessor ends the right spine, which is the path
+        bool is_end = (hint == FakeNode());
+        if (is_end) {
+            while (!temp->IsRightLink()) {
+                temp = temp->Right();
+                path.Push(temp);
+                instrumentation_.OnVisit();
+            }
         }
-        explicit Node() : is_right_link_(true), left_(nullptr), right_(this), data_() {
+        Node* pred = is_end ? temp : Prev(hint);
+        bool is_begin = (pred == FakeNode());
+        if ((!is_begin && !Less(pred->data_.first, key)) || (!is_end && !Less(key, hint->data_.first))) {
+            return InsertNode(std::forward<K>(key), std::forward<Args>(args)...);
         }
-    };
-
-    void LKP(Node* nd, std::vector<std::pair<const Key, Value>>& res) const {
 
-        if (nd->left_ != nullptr) {
-            LKP(nd->left_, res);
+        bool is_left = !is_end && hint->IsLeftLink();
+        Node* target = is_left ? hint : pred;
+        while (temp != target) {
+            bool go_left = is_begin || Less(key, temp->data_.first);
+            if (go_left ? temp->IsLeftLink() : temp->IsRightLink()) {
+                // The hint is from another map
+                return InsertNode(std::forward<K>(key), std::forward<Args>(args)...);
+            }
+            temp = go_left ? temp->Left() : temp->Right();
+            path.Push(temp);
+            instrumentation_.OnVisit();
         }
 
-        res.push_back(std::make_pair(nd->data_.first, nd->data_.second));
-
-        if (!nd->is_right_link_) {
-            LKP(nd->right_, res);
+        if (is_left) {
+            return {AttachLeft(path, std::forward<K>(key), std::forward<Args>(args)...), true};
         }
+        return {AttachRight(path, std::forward<K>(key), std::forward<Args>(args)...), true};
     }
 
-    void PKL(Node* nd, std::vector<std::pair<const Key, Value>>& res) const {
-
-        if (!nd->is_right_link_) {
-            PKL(nd->right_, res);
-        }
+    // The new node is between path.Top() without a left subtree and its predecessor
+    template <typename... Args>
+    Node* AttachLeft(Path& path, Args&&... args) {
+        Node* temp = path.Top();
+        Node* node = NewNode(std::forward<Args>(args)...);
+        node->SetLeftLink(true);
+        node->SetLeft(temp->Left());
+        node->SetRightLink(true);
+        node->SetRight(temp);
+        temp->SetLeftLink(false);
+        temp->SetLeft(node);
+
+        FinishInsert(path);
+        return node;
+    }
 
-        res.push_back(std::make_pair(nd->data_.first, nd->data_.second));
+    // The new node is between path.Top() without a right subtree and its successor
+    template <typename... Args>
+    Node* AttachRight(Path& path, Args&&... args) {
+        Node* temp = path.Top();
+        Node* node = NewNode(std::forward<Args>(args)...);
+        node->SetLeftLink(true);
+        node->SetLeft(temp);
+        node->SetRightLink(true);
+        node->SetRight(temp->Right());
+        temp->SetRightLink(false);
+        temp->SetRight(node);
+
+        FinishInsert(path);
+        return node;
+    }
 
-        if (nd->left_ != nullptr) {
-            PKL(nd->left_, res);
+    void FinishInsert(Path& path) noexcept {
+        ++sz_;
+        for (size_t i = 1; i < path.size; ++i) {
+            path.nodes[i]->SetSize(path.nodes[i]->GetSize() + 1);
         }
+        Rebalance(path);
     }
 
     void Del() {
@@ -448,22 +1696,43 @@ private:
             prev = curr;
             ++curr;
             --sz_;
-            delete prev.current_;
+            DeleteNode(prev.current_);
         }
     }
 
 private:
     Compare comp_;
-    Node* root_;
     size_t sz_;
-    Node* fake_node_;
+    // The fake node is built here by the constructor. A Node member would
+    // bring the const key into the map and make it read-only for asm
+    // operands like benchmark::DoNotOptimize
+    alignas(Node) std::byte fake_node_[sizeof(Node)];
+    Storage<Node> storage_;
+    // Hooks are called from const lookups too
+    [[no_unique_address]] mutable Instrumentation instrumentation_;
+    // Erased nodes linked by left links, empty without CheckedIterators
+    Node* recycled_ = nullptr;
 };
 
+// Map with nodes in slabs: cheaper inserts and O(number of slabs) Clear
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using ArenaMap = Map<Key, Value, Compare, ArenaStorage>;
+
+// Map that counts its work, see Stats()
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using InstrumentedMap = Map<Key, Value, Compare, HeapStorage, CountingInstrumentation>;
+
+// Map that catches stale iterators, see CheckedIterators
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using CheckedMap = Map<Key, Value, Compare, HeapStorage, NoInstrumentation, CheckedIterators>;
+
 namespace std {
 // Global swap overloading
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Compare, template <typename> class Storage,
+          typename Instrumentation, typename IteratorChecks>
 // NOLINTNEXTLINE
-void swap(Map<Key, Value>& a, Map<Key, Value>& b) {
+void swap(Map<Key, Value, Compare, Storage, Instrumentation, IteratorChecks>& a,
+          Map<Key, Value, Compare, Storage, Instrumentation, IteratorChecks>& b) {
     a.Swap(b);
 }
 }  // namespace std
@@ -0,0 +1,206 @@
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../map.hpp"
+
+// Maps with CheckedIterators: stale iterators throw instead of dangling
+
+TEST(CheckedIteratorsTest, InvalidatedIterators) {
+  CheckedMap<int, int> mp;
+  std::vector<CheckedMap<int, int>::MapIterator> iterators;
+  for (int i = 0; i < 1000; ++i) {
+    mp[i] = i;
+  }
+  for (int i = 0; i < 1000; ++i) {
+    iterators.push_back(mp.Find(i));
+  }
+
+  for (int i = 0; i < 1000; i += 3) {
+    if (i % 2 == 0) {
+      mp.Erase(i);
+    } else {
+      mp.Erase(iterators[i]);
+    }
+  }
+
+  // Erased elements are caught, the rest survive rebalancing
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 3 == 0) {
+      ASSERT_THROW(*iterators[i], std::logic_error);
+      ASSERT_THROW(++iterators[i], std::logic_error);
+      ASSERT_THROW(--iterators[i], std::logic_error);
+      ASSERT_THROW(mp.Erase(iterators[i]), std::logic_error);
+    } else {
+      ASSERT_EQ(iterators[i]->first, i);
+      ++iterators[i];
+      if (i == 998) {
+        ASSERT_EQ(iterators[i], mp.End());
+      } else {
+        ASSERT_EQ(iterators[i]->first, i % 3 == 2 ? i + 2 : i + 1);
+      }
+    }
+  }
+  ASSERT_EQ(mp.Size(), 666);
+}
+
+// A node of an erased element gets the next inserted one: the old iterator
+// points to a live element again and is still caught
+TEST(CheckedIteratorsTest, ReusedNodes) {
+  CheckedMap<int, int> mp;
+  mp[1] = 1;
+  mp[2] = 2;
+
+  auto stale = mp.Find(1);
+  const auto* address = &*stale;
+  for (int i = 0; i < 100; ++i) {
+    mp.Erase(mp.Find(1));
+    ASSERT_THROW(*stale, std::logic_error);
+    mp[1] = i;
+    ASSERT_EQ(&*mp.Find(1), address);
+    ASSERT_THROW(*stale, std::logic_error);
+    ASSERT_THROW(mp.Erase(stale), std::logic_error);
+  }
+  ASSERT_EQ(mp.Size(), 2);
+  ASSERT_EQ(mp.Find(1)->second, 99);
+}
+
+TEST(CheckedIteratorsTest, RandomOperations) {
+  CheckedMap<int, int> mp;
+  std::map<int, int> expected;
+  std::mt19937 mt(11);
+  for (int i = 0; i < 20000; ++i) {
+    int key = static_cast<int>(mt() % 500);
+    if (mt() % 2 == 0) {
+      mp[key] = i;
+      expected[key] = i;
+    } else if (auto it = mp.Find(key); it != mp.End()) {
+      auto next = mp.Erase(it);
+      auto expected_next = expected.erase(expected.find(key));
+      if (expected_next == expected.end()) {
+        ASSERT_EQ(next, mp.End());
+      } else {
+        ASSERT_EQ(next->first, expected_next->first);
+      }
+      ASSERT_THROW(*it, std::logic_error);
+    }
+  }
+
+  ASSERT_EQ(mp.Size(), expected.size());
+  auto it = mp.Begin();
+  for (const auto& [key, value] : expected) {
+    ASSERT_EQ(it->first, key);
+    ASSERT_EQ(it->second, value);
+    ++it;
+  }
+  ASSERT_EQ(it, mp.End());
+}
+
+static int64_t live_nodes = 0;
+static size_t node_size = 0;
+
+template <typename T>
+class LiveCountingStorage: public HeapStorage<T> {
+public:
+  template <typename... Args>
+  T* New(Args&&... args) {
+    T* object = HeapStorage<T>::New(std::forward<Args>(args)...);
+    ++live_nodes;
+    node_size = sizeof(T);
+    return object;
+  }
+
+  void Delete(T* object) noexcept {
+    --live_nodes;
+    HeapStorage<T>::Delete(object);
+  }
+};
+
+template <typename Key, typename Value>
+using CountedCheckedMap = Map<Key, Value, std::less<Key>, LiveCountingStorage, NoInstrumentation, CheckedIterators>;
+
+// A long-lived cache erases and inserts all the time: erased nodes are
+// reused, so memory doesn't grow with the number of erasures
+TEST(CheckedIteratorsTest, RecycledNodesAreBounded) {
+  live_nodes = 0;
+  {
+    CountedCheckedMap<int, int> mp;
+    for (int i = 0; i < 1000; ++i) {
+      mp[i] = i;
+    }
+
+    std::mt19937 mt(5);
+    for (int i = 0; i < 200000; ++i) {
+      int key = static_cast<int>(mt() % 1000);
+      if (i % 2 == 0) {
+        mp.Erase(key);
+      } else {
+        mp.Erase(mp.Find(key));
+      }
+      mp[key] = i;
+      ASSERT_EQ(live_nodes, 1000);
+    }
+    ASSERT_EQ(mp.Size(), 1000);
+
+    mp.Clear();
+    ASSERT_EQ(live_nodes, 0);
+    mp[1] = 1;
+  }
+  ASSERT_EQ(live_nodes, 0);
+}
+
+struct ThrowingValue {
+  explicit ThrowingValue(int value) : value(value) {
+    if (value < 0) {
+      throw std::runtime_error("Negative value");
+    }
+  }
+
+  int value;
+};
+
+// A recycled node stays recycled if the new element throws
+TEST(CheckedIteratorsTest, ThrowingElement) {
+  live_nodes = 0;
+  {
+    CountedCheckedMap<int, ThrowingValue> mp;
+    mp.TryEmplace(1, 1);
+    auto stale = mp.Find(1);
+    mp.Erase(1);
+
+    ASSERT_THROW(mp.TryEmplace(2, -1), std::runtime_error);
+    ASSERT_TRUE(mp.IsEmpty());
+    ASSERT_THROW(*stale, std::logic_error);
+    ASSERT_EQ(live_nodes, 1);
+
+    mp.TryEmplace(2, 2);
+    ASSERT_EQ(live_nodes, 1);
+    ASSERT_EQ(mp.Find(2)->second.value, 2);
+    ASSERT_THROW(*stale, std::logic_error);
+  }
+  ASSERT_EQ(live_nodes, 0);
+}
+
+// Generations cost memory only in checked maps
+TEST(CheckedIteratorsTest, Layout) {
+  static_assert(sizeof(Map<int, int>::MapIterator) == sizeof(void*));
+  static_assert(sizeof(CheckedMap<int, int>::MapIterator) == 2 * sizeof(void*));
+
+  Map<int, int, std::less<int>, LiveCountingStorage> unchecked;
+  unchecked[1] = 1;
+  ASSERT_EQ(node_size, 32);
+
+  CountedCheckedMap<int, int> checked;
+  checked[1] = 1;
+  ASSERT_EQ(node_size, 40);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
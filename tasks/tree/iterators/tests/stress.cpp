@@ -1,13 +1,19 @@
+#include <algorithm>
+#include <climits>
 #include <random>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 #include <fmt/core.h>
 
 #include "../map.hpp"
 
-void ConstructRandomMap(Map<int, int>& mp, int sz) {
+template <typename MapType>
+void ConstructRandomMap(MapType& mp, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -31,7 +37,8 @@ void ConstructRandomMap(std::map<int, int>& mp, int sz) {
   }
 }
 
-void ConstructLinearMap(Map<int, int>& mp, int sz) {
+template <typename MapType>
+void ConstructLinearMap(MapType& mp, int sz) {
   while(sz) {
     mp.Insert(std::pair{sz, 1});
     --sz;
@@ -54,6 +61,14 @@ void BM_CustomMapRandomInsert(benchmark::State& state) {
   state.SetComplexityN(state.range(0));
 }
 
+void BM_ArenaMapRandomInsert(benchmark::State& state) {
+  ArenaMap<int, int> mp;
+  for (auto _ : state) {
+    ConstructRandomMap(mp, state.range(0));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
 void BM_StdMapRandomInsert(benchmark::State& state) {
   std::map<int, int> mp;
   for (auto _ : state) {
@@ -78,6 +93,525 @@ void BM_StdMapLinearInsert(benchmark::State& state) {
   state.SetComplexityN(state.range(0));
 }
 
+// Lookups of long string keys given as std::string_view. Without a transparent
+// comparator every lookup constructs (and allocates) a std::string
+std::vector<std::string> LongKeys(int sz) {
+  std::vector<std::string> keys;
+  keys.reserve(sz);
+  for (int i = 0; i < sz; ++i) {
+    keys.push_back(fmt::format("configuration/section/key-{:08}", i));
+  }
+  return keys;
+}
+
+template <typename StringMap, bool kIsTransparent>
+void BM_StringViewFind(benchmark::State& state) {
+  auto keys = LongKeys(state.range(0));
+  StringMap mp;
+  for (const auto& key: keys) {
+    mp[key] = 1;
+  }
+  std::mt19937 mt(42);
+
+  for (auto _ : state) {
+    std::string_view key = keys[mt() % keys.size()];
+    if constexpr (kIsTransparent) {
+      benchmark::DoNotOptimize(mp.Find(key));
+    } else {
+      benchmark::DoNotOptimize(mp.Find(std::string(key)));
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapStringViewFindTemporary(benchmark::State& state) {
+  BM_StringViewFind<Map<std::string, int>, false>(state);
+}
+
+void BM_CustomMapStringViewFindTransparent(benchmark::State& state) {
+  BM_StringViewFind<Map<std::string, int, std::less<>>, true>(state);
+}
+
+// Appends of increasing keys with and without the End() hint
+template <bool kIsHinted, typename Keys>
+void BM_SequentialInsert(benchmark::State& state, const Keys& keys) {
+  using Key = typename Keys::value_type;
+  for (auto _ : state) {
+    Map<Key, int> mp;
+    for (const auto& key: keys) {
+      if constexpr (kIsHinted) {
+        mp.Insert(mp.End(), {key, 1});
+      } else {
+        mp.Insert({key, 1});
+      }
+    }
+    benchmark::DoNotOptimize(mp.Size());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+std::vector<int> IncreasingKeys(int sz) {
+  std::vector<int> keys(sz);
+  for (int i = 0; i < sz; ++i) {
+    keys[i] = i;
+  }
+  return keys;
+}
+
+void BM_CustomMapSequentialInsert(benchmark::State& state) {
+  BM_SequentialInsert<false>(state, IncreasingKeys(state.range(0)));
+}
+
+void BM_CustomMapSequentialHintedInsert(benchmark::State& state) {
+  BM_SequentialInsert<true>(state, IncreasingKeys(state.range(0)));
+}
+
+void BM_CustomMapSequentialStringInsert(benchmark::State& state) {
+  BM_SequentialInsert<false>(state, LongKeys(state.range(0)));
+}
+
+void BM_CustomMapSequentialHintedStringInsert(benchmark::State& state) {
+  BM_SequentialInsert<true>(state, LongKeys(state.range(0)));
+}
+
+// Loading of sorted keys into an empty map
+std::vector<std::pair<int, int>> SortedPairs(int sz) {
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(sz);
+  for (int i = 0; i < sz; ++i) {
+    pairs.emplace_back(i, 1);
+  }
+  return pairs;
+}
+
+void BM_CustomMapSortedLoadInsert(benchmark::State& state) {
+  auto pairs = SortedPairs(state.range(0));
+  for (auto _ : state) {
+    Map<int, int> mp;
+    for (const auto& val: pairs) {
+      mp.Insert(val);
+    }
+    benchmark::DoNotOptimize(mp.Size());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapSortedLoadFromSorted(benchmark::State& state) {
+  auto pairs = SortedPairs(state.range(0));
+  for (auto _ : state) {
+    auto mp = Map<int, int>::FromSorted(pairs.begin(), pairs.end());
+    benchmark::DoNotOptimize(mp.Size());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_ArenaMapSortedLoadFromSorted(benchmark::State& state) {
+  auto pairs = SortedPairs(state.range(0));
+  for (auto _ : state) {
+    auto mp = ArenaMap<int, int>::FromSorted(pairs.begin(), pairs.end());
+    benchmark::DoNotOptimize(mp.Size());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// std::map builds from a sorted range in O(n) too
+void BM_StdMapSortedLoad(benchmark::State& state) {
+  auto pairs = SortedPairs(state.range(0));
+  for (auto _ : state) {
+    std::map<int, int> mp(pairs.begin(), pairs.end());
+    benchmark::DoNotOptimize(mp.size());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Lookups in a map built from sorted keys: O(log n) only if the tree is balanced
+void BM_CustomMapLinearFind(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  int key = 0;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      key = key % state.range(0) + 1;
+      benchmark::DoNotOptimize(mp.Find(key));
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdMapLinearFind(benchmark::State& state) {
+  std::map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  int key = 0;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      key = key % state.range(0) + 1;
+      benchmark::DoNotOptimize(mp.find(key));
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Bytes of live nodes of the maps below, without the allocator overhead
+static size_t node_bytes = 0;
+
+template <typename T>
+class CountingStorage: public HeapStorage<T> {
+public:
+  template <typename... Args>
+  T* New(Args&&... args) {
+    T* object = HeapStorage<T>::New(std::forward<Args>(args)...);
+    node_bytes += sizeof(T);
+    return object;
+  }
+
+  void Delete(T* object) noexcept {
+    node_bytes -= sizeof(T);
+    HeapStorage<T>::Delete(object);
+  }
+};
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) noexcept {
+  }
+
+  T* allocate(size_t n) {
+    node_bytes += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* object, size_t n) noexcept {
+    node_bytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(object, n);
+  }
+
+  bool operator==(const CountingAllocator&) const = default;
+};
+
+void BM_CustomMapMemory(benchmark::State& state) {
+  for (auto _ : state) {
+    Map<int, int, std::less<int>, CountingStorage> mp;
+    ConstructLinearMap(mp, state.range(0));
+    state.counters["bytes_per_element"] = static_cast<double>(node_bytes) / state.range(0);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdMapMemory(benchmark::State& state) {
+  for (auto _ : state) {
+    std::map<int, int, std::less<int>, CountingAllocator<std::pair<const int, int>>> mp;
+    for (int key = state.range(0); key > 0; --key) {
+      mp.insert(std::pair{key, 1});
+    }
+    state.counters["bytes_per_element"] = static_cast<double>(node_bytes) / state.range(0);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Random lookups: once the tree is out of cache, smaller nodes mean fewer misses
+void BM_CustomMapRandomFind(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  std::mt19937 mt(42);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.Find(static_cast<int>(mt() % state.range(0)) + 1));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdMapRandomFind(benchmark::State& state) {
+  std::map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  std::mt19937 mt(42);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.find(static_cast<int>(mt() % state.range(0)) + 1));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Counters of InstrumentedMap: why a tree is slow, besides how slow it is
+void ReportStats(benchmark::State& state, const MapStats& stats) {
+  state.counters["comparisons_per_lookup"] = stats.ComparisonsPerLookup();
+  state.counters["average_depth"] = stats.AverageDepth();
+  state.counters["max_depth"] = static_cast<double>(stats.max_depth);
+  state.counters["rotations_per_lookup"] = static_cast<double>(stats.rotations) / stats.lookups;
+  state.counters["allocations_per_lookup"] = static_cast<double>(stats.allocations) / stats.lookups;
+}
+
+void BM_InstrumentedMapRandomInsert(benchmark::State& state) {
+  InstrumentedMap<int, int> mp;
+  for (auto _ : state) {
+    ConstructRandomMap(mp, state.range(0));
+  }
+  ReportStats(state, mp.Stats());
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_InstrumentedMapLinearInsert(benchmark::State& state) {
+  MapStats stats;
+  for (auto _ : state) {
+    InstrumentedMap<int, int> mp;
+    ConstructLinearMap(mp, state.range(0));
+    stats = mp.Stats();
+  }
+  ReportStats(state, stats);
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_InstrumentedMapRandomFind(benchmark::State& state) {
+  InstrumentedMap<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  mp.ResetStats();
+  std::mt19937 mt(42);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.Find(static_cast<int>(mt() % state.range(0)) + 1));
+  }
+  ReportStats(state, mp.Stats());
+  state.SetComplexityN(state.range(0));
+}
+
+// Two maps of n random keys from [0, 2n): about a half of the keys are shared
+void ConstructOverlappingMaps(Map<int, int>& lhs, Map<int, int>& rhs, int sz) {
+  std::mt19937 mt(42);
+  for (int i = 0; i < sz; ++i) {
+    lhs[static_cast<int>(mt() % (2 * sz))] = 1;
+    rhs[static_cast<int>(mt() % (2 * sz))] = 2;
+  }
+}
+
+// Union the old way: insert every element of one map into a copy of the other
+void BM_CustomMapUnionByInsert(benchmark::State& state) {
+  Map<int, int> lhs;
+  Map<int, int> rhs;
+  ConstructOverlappingMaps(lhs, rhs, state.range(0));
+  for (auto _ : state) {
+    auto view = lhs.Ascending();
+    auto res = Map<int, int>::FromSorted(view.begin(), view.end());
+    for (const auto& val: rhs.Ascending()) {
+      res.Insert(val);
+    }
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapUnion(benchmark::State& state) {
+  Map<int, int> lhs;
+  Map<int, int> rhs;
+  ConstructOverlappingMaps(lhs, rhs, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.Union(rhs));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapIntersectByFind(benchmark::State& state) {
+  Map<int, int> lhs;
+  Map<int, int> rhs;
+  ConstructOverlappingMaps(lhs, rhs, state.range(0));
+  for (auto _ : state) {
+    Map<int, int> res;
+    for (const auto& val: lhs.Ascending()) {
+      if (rhs.Contains(val.first)) {
+        res.Insert(val);
+      }
+    }
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapIntersect(benchmark::State& state) {
+  Map<int, int> lhs;
+  Map<int, int> rhs;
+  ConstructOverlappingMaps(lhs, rhs, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.Intersect(rhs));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Merge takes the nodes of the other map: a new pair of maps every iteration
+void BM_CustomMapMerge(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    Map<int, int> lhs;
+    Map<int, int> rhs;
+    ConstructOverlappingMaps(lhs, rhs, state.range(0));
+    state.ResumeTiming();
+
+    lhs.Merge(std::move(rhs));
+    benchmark::DoNotOptimize(lhs);
+
+    state.PauseTiming();
+    lhs.Clear();
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Sum over a window of 1% of the keys: lazy Range vs filtering a full Values() copy
+void BM_CustomMapRangeScan(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  int width = std::max<int>(1, state.range(0) / 100);
+  int lo = 1;
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& [key, value] : mp.Range(lo, lo + width)) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+    lo = lo % (state.range(0) - width) + 1;
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapValuesScan(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  int width = std::max<int>(1, state.range(0) / 100);
+  int lo = 1;
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& [key, value] : mp.Values()) {
+      if (lo <= key && key < lo + width) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+    lo = lo % (state.range(0) - width) + 1;
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdMapRangeScan(benchmark::State& state) {
+  std::map<int, int> mp;
+  ConstructLinearMap(mp, state.range(0));
+  int width = std::max<int>(1, state.range(0) / 100);
+  int lo = 1;
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (auto it = mp.lower_bound(lo), last = mp.lower_bound(lo + width); it != last; ++it) {
+      sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+    lo = lo % (state.range(0) - width) + 1;
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Median lookup: Select on subtree sizes vs indexing a Values() copy
+void BM_CustomMapSelect(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  size_t k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.Select(k));
+    k = (k + mp.Size() / 2 + 1) % mp.Size();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapValuesSelect(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  size_t k = 0;
+  for (auto _ : state) {
+    auto values = mp.Values();
+    benchmark::DoNotOptimize(values[k].second);
+    k = (k + mp.Size() / 2 + 1) % mp.Size();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapCountInRange(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  int lo = INT_MIN;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.CountInRange(lo, lo + (INT_MAX / 4)));
+    lo += 7919;
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Full walks over 1<<20 elements; "bytes" is the memory the walk allocates
+void BM_CustomMapAscendingView(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& [key, value] : mp.Ascending()) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["bytes"] = 0;
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapDescendingView(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& [key, value] : mp.Descending()) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["bytes"] = 0;
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapReverseIterators(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (auto it = mp.RBegin(); it != mp.REnd(); ++it) {
+      sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["bytes"] = 0;
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_StdMapReverseIterators(benchmark::State& state) {
+  std::map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (auto it = mp.rbegin(); it != mp.rend(); ++it) {
+      sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["bytes"] = 0;
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapValues(benchmark::State& state) {
+  Map<int, int> mp;
+  ConstructRandomMap(mp, state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& [key, value] : mp.Values(false)) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["bytes"] = static_cast<double>(mp.Size() * sizeof(std::pair<const int, int>));
+  state.SetComplexityN(state.range(0));
+}
+
 void BM_CustomMapErase(benchmark::State& state) {
   Map<int, int> mp;
   std::random_device rd;
@@ -96,6 +630,55 @@ void BM_CustomMapErase(benchmark::State& state) {
   state.SetComplexityN(state.range(0));
 }
 
+// The caller already holds an iterator: LowerBound of a random key is erased.
+// By key the same descent is done once more with two comparisons per level
+template <bool kIsByIterator, typename Keys>
+void BM_EraseFound(benchmark::State& state, const Keys& keys) {
+  using Key = typename Keys::value_type;
+  std::mt19937 mt(42);
+  for (auto _ : state) {
+    state.PauseTiming();
+    Map<Key, int> mp;
+    for (const auto& key: keys) {
+      mp.Insert(mp.End(), {key, 1});
+    }
+    state.ResumeTiming();
+
+    for (size_t i = 0; i < keys.size() / 2; ++i) {
+      auto it = mp.LowerBound(keys[mt() % keys.size()]);
+      if (it == mp.End()) {
+        continue;
+      }
+      if constexpr (kIsByIterator) {
+        mp.Erase(it);
+      } else {
+        mp.Erase(it->first);
+      }
+    }
+
+    state.PauseTiming();
+    mp.Clear();
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapEraseFoundByKey(benchmark::State& state) {
+  BM_EraseFound<false>(state, IncreasingKeys(state.range(0)));
+}
+
+void BM_CustomMapEraseFoundByIterator(benchmark::State& state) {
+  BM_EraseFound<true>(state, IncreasingKeys(state.range(0)));
+}
+
+void BM_CustomMapEraseFoundStringByKey(benchmark::State& state) {
+  BM_EraseFound<false>(state, LongKeys(state.range(0)));
+}
+
+void BM_CustomMapEraseFoundStringByIterator(benchmark::State& state) {
+  BM_EraseFound<true>(state, LongKeys(state.range(0)));
+}
+
 void BM_StdMapErase(benchmark::State& state) {
   std::map<int, int> mp;
   std::random_device rd;
@@ -123,6 +706,27 @@ void BM_CustomMapClear(benchmark::State& state) {
   state.SetComplexityN(state.range(0));
 }
 
+// Only Clear itself is measured
+template <typename MapType>
+void BM_ClearLatency(benchmark::State& state) {
+  MapType mp;
+  for (auto _ : state) {
+    state.PauseTiming();
+    ConstructRandomMap(mp, state.range(0));
+    state.ResumeTiming();
+    mp.Clear();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CustomMapClearLatency(benchmark::State& state) {
+  BM_ClearLatency<Map<int, int>>(state);
+}
+
+void BM_ArenaMapClearLatency(benchmark::State& state) {
+  BM_ClearLatency<ArenaMap<int, int>>(state);
+}
+
 void BM_StdMapClear(benchmark::State& state) {
   std::map<int, int> mp;
   for (auto _ : state) {
@@ -134,12 +738,54 @@ void BM_StdMapClear(benchmark::State& state) {
 
 
 BENCHMARK(BM_CustomMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ArenaMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StdMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomMapLinearInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdMapLinearInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapLinearInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapLinearInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapStringViewFindTemporary)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_CustomMapStringViewFindTransparent)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_CustomMapSequentialInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSequentialHintedInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSequentialStringInsert)->Range(1<<10, 1<<18)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSequentialHintedStringInsert)->Range(1<<10, 1<<18)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSortedLoadInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapSortedLoadFromSorted)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ArenaMapSortedLoadFromSorted)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapSortedLoad)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapLinearFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapLinearFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapMemory)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapMemory)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapRandomFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_StdMapRandomFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_InstrumentedMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InstrumentedMapLinearInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InstrumentedMapRandomFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_CustomMapUnionByInsert)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapUnion)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapIntersectByFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapIntersect)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapMerge)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapRangeScan)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CustomMapValuesScan)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StdMapRangeScan)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CustomMapSelect)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CustomMapValuesSelect)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CustomMapCountInRange)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CustomMapAscendingView)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapDescendingView)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapReverseIterators)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdMapReverseIterators)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapValues)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_CustomMapErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapEraseFoundByKey)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapEraseFoundByIterator)->Range(1<<10, 1<<20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapEraseFoundStringByKey)->Range(1<<10, 1<<18)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapEraseFoundStringByIterator)->Range(1<<10, 1<<18)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StdMapErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_CustomMapClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StdMapClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CustomMapClearLatency)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ArenaMapClearLatency)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
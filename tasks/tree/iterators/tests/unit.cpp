@@ -1,9 +1,16 @@
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cmath>
 #include <future>
 #include <map>
 #include <iostream>
+#include <random>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
+#include <vector>
 
 #include <fmt/core.h>
 #include <gtest/gtest.h>
@@ -105,6 +112,53 @@ TEST(EmptyMapTest, SimpleSwap) {
   ASSERT_EQ(map[2], 14);
 }
 
+// A vector of maps moves them on reallocation instead of copying
+TEST(EmptyMapTest, NothrowMove) {
+  static_assert(std::is_nothrow_move_constructible_v<Map<int, int>>);
+  static_assert(std::is_nothrow_move_constructible_v<ArenaMap<int, int>>);
+
+  std::vector<Map<int, int>> maps;
+  for (int i = 0; i < 100; ++i) {
+    maps.emplace_back()[i] = i;
+  }
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(maps[i].Size(), 1);
+    ASSERT_EQ(maps[i][i], i);
+  }
+}
+
+TEST(EmptyMapTest, MoveKeepsThreads) {
+  Map<int, int> map;
+  for (int i = 0; i < 10; ++i) {
+    map[i] = i;
+  }
+
+  Map<int, int> moved(std::move(map));
+  ASSERT_TRUE(map.IsEmpty());
+  ASSERT_EQ(map.Begin(), map.End());
+
+  std::vector<int> forward;
+  for (auto it = moved.Begin(); it != moved.End(); ++it) {
+    forward.push_back(it->first);
+  }
+  std::vector<int> backward;
+  for (auto it = moved.RBegin(); it != moved.REnd(); ++it) {
+    backward.push_back(it->first);
+  }
+  ASSERT_EQ(forward.size(), 10);
+  ASSERT_EQ(backward.size(), 10);
+  ASSERT_TRUE(std::is_sorted(forward.begin(), forward.end()));
+  ASSERT_TRUE(std::is_sorted(backward.rbegin(), backward.rend()));
+  ASSERT_EQ(--moved.End(), moved.Find(9));
+
+  map[42] = 1;
+  moved.Swap(map);
+  ASSERT_EQ(moved.Begin()->first, 42);
+  ASSERT_EQ(++moved.Begin(), moved.End());
+  ASSERT_EQ(--map.End(), map.Find(9));
+  ASSERT_EQ(map.Begin()->first, 0);
+}
+
 TEST(EmptyMapTest, StdSwap) {
   Map<int, int> map;
   map[1] = 5;
@@ -372,6 +426,928 @@ TEST_F(MapTest, CustomComparator) {
 }
 
 
+template <typename MapType, typename Key, typename Value>
+void ExpectSameContent(const MapType& mp, const std::map<Key, Value>& expected) {
+  ASSERT_EQ(mp.Size(), expected.size());
+
+  auto it = mp.Begin();
+  for (const auto& val: expected) {
+    ASSERT_NE(it, mp.End());
+    ASSERT_EQ(*it, val);
+    ++it;
+  }
+  ASSERT_EQ(it, mp.End());
+
+  auto values = mp.Values(false);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.rbegin(), expected.rend()));
+
+  // Left threads: the same walk backwards
+  for (auto expected_it = expected.rbegin(); expected_it != expected.rend(); ++expected_it) {
+    --it;
+    ASSERT_EQ(*it, *expected_it);
+  }
+  ASSERT_EQ(it, mp.Begin());
+}
+
+TEST(BalancedMapTest, SortedInsertAndErase) {
+  Map<int, int> mp;
+  std::map<int, int> expected;
+  for (int i = 0; i < 10000; ++i) {
+    mp.Insert({i, -i});
+    expected.insert({i, -i});
+  }
+  ExpectSameContent(mp, expected);
+
+  for (int i = 9999; i >= 0; i -= 2) {
+    mp.Erase(i);
+    expected.erase(i);
+  }
+  ExpectSameContent(mp, expected);
+
+  for (int i = 0; i < 10000; i += 2) {
+    mp.Erase(i);
+  }
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(mp.Begin(), mp.End());
+}
+
+TEST(BalancedMapTest, RandomOperations) {
+  std::mt19937 mt(42);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+
+  for (int i = 0; i < 20000; ++i) {
+    int key = static_cast<int>(mt() % 1000);
+    switch (mt() % 4) {
+      case 0:
+        mp.Insert({key, i});
+        expected.insert_or_assign(key, i);
+        break;
+      case 1:
+        mp[key] = i;
+        expected[key] = i;
+        break;
+      case 2:
+        if (expected.erase(key) == 1) {
+          mp.Erase(key);
+        } else {
+          EXPECT_ANY_THROW(mp.Erase(key));
+        }
+        break;
+      case 3:
+        ASSERT_EQ(mp.Find(key) != mp.End(), expected.contains(key));
+        break;
+    }
+
+    if (i % 1000 == 0) {
+      ExpectSameContent(mp, expected);
+    }
+  }
+  ExpectSameContent(mp, expected);
+
+  mp.Clear();
+  ASSERT_EQ(mp.Begin(), mp.End());
+  mp[1] = 1;
+  ASSERT_EQ(mp.Size(), 1);
+}
+
+TEST(BalancedMapTest, IteratorsSurviveRebalancing) {
+  Map<int, int> mp;
+  for (int i = 0; i < 1000; ++i) {
+    mp[i] = i;
+  }
+  auto it = mp.Find(500);
+  for (int i = 0; i < 1000; i += 3) {
+    if (i != 500) {
+      mp.Erase(i);
+    }
+  }
+  ASSERT_EQ(it->first, 500);
+  ASSERT_EQ((++it)->first, 502);
+}
+
+
+TEST_F(MapTest, LowerUpperBound) {
+  // Keys: -10 0 1 3 5 10 90
+  ASSERT_EQ(mp.LowerBound(3)->first, 3);
+  ASSERT_EQ(mp.UpperBound(3)->first, 5);
+  ASSERT_EQ(mp.LowerBound(4)->first, 5);
+  ASSERT_EQ(mp.UpperBound(4)->first, 5);
+  ASSERT_EQ(mp.LowerBound(-100)->first, -10);
+  ASSERT_EQ(mp.LowerBound(90)->first, 90);
+  ASSERT_EQ(mp.UpperBound(90), mp.End());
+  ASSERT_EQ(mp.LowerBound(91), mp.End());
+
+  Map<int, int> empty;
+  ASSERT_EQ(empty.LowerBound(1), empty.End());
+  ASSERT_EQ(empty.UpperBound(1), empty.End());
+}
+
+TEST_F(MapTest, EqualRange) {
+  auto [first, last] = mp.EqualRange(5);
+  ASSERT_EQ(first->first, 5);
+  ASSERT_EQ(last->first, 10);
+
+  auto [missing_first, missing_last] = mp.EqualRange(6);
+  ASSERT_EQ(missing_first, missing_last);
+  ASSERT_EQ(missing_first->first, 10);
+}
+
+TEST_F(MapTest, Range) {
+  std::vector<int> keys;
+  for (const auto& [key, value] : mp.Range(0, 10)) {
+    keys.push_back(key);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{0, 1, 3, 5}));
+
+  ASSERT_TRUE(mp.Range(6, 10).IsEmpty());
+  ASSERT_TRUE(mp.Range(10, 0).IsEmpty());
+  ASSERT_TRUE(mp.Range(100, 200).IsEmpty());
+
+  auto all = mp.Range(-100, 100);
+  ASSERT_EQ(std::distance(all.Begin(), all.End()), sz);
+}
+
+TEST(BalancedMapTest, RandomRanges) {
+  std::mt19937 mt(42);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+  for (int i = 0; i < 5000; ++i) {
+    int key = static_cast<int>(mt() % 20000);
+    mp[key] = i;
+    expected[key] = i;
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    int lo = static_cast<int>(mt() % 21000) - 500;
+    int hi = lo + static_cast<int>(mt() % 2000);
+
+    auto range = mp.Range(lo, hi);
+    ASSERT_TRUE(std::equal(range.begin(), range.end(), expected.lower_bound(lo), expected.lower_bound(hi)));
+
+    auto lower = mp.LowerBound(lo);
+    auto expected_lower = expected.lower_bound(lo);
+    ASSERT_EQ(lower == mp.End(), expected_lower == expected.end());
+    if (lower != mp.End()) {
+      ASSERT_EQ(*lower, *expected_lower);
+    }
+
+    auto upper = mp.UpperBound(lo);
+    auto expected_upper = expected.upper_bound(lo);
+    ASSERT_EQ(upper == mp.End(), expected_upper == expected.end());
+    if (upper != mp.End()) {
+      ASSERT_EQ(*upper, *expected_upper);
+    }
+  }
+}
+
+
+TEST_F(MapTest, RankSelect) {
+  // Keys: -10 0 1 3 5 10 90
+  std::vector<int> keys{-10, 0, 1, 3, 5, 10, 90};
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(mp.Rank(keys[i]), i);
+    ASSERT_EQ(mp.Select(i)->first, keys[i]);
+  }
+  ASSERT_EQ(mp.Rank(-100), 0);
+  ASSERT_EQ(mp.Rank(4), 4);
+  ASSERT_EQ(mp.Rank(100), sz);
+  ASSERT_EQ(mp.Select(sz), mp.End());
+
+  ASSERT_EQ(mp.CountInRange(0, 10), 4);
+  ASSERT_EQ(mp.CountInRange(-100, 100), sz);
+  ASSERT_EQ(mp.CountInRange(10, 0), 0);
+}
+
+TEST(BalancedMapTest, RandomOrderStatistics) {
+  std::mt19937 mt(42);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+
+  for (int i = 0; i < 20000; ++i) {
+    int key = static_cast<int>(mt() % 3000);
+    if (mt() % 3 == 0) {
+      if (expected.erase(key) == 1) {
+        mp.Erase(key);
+      }
+    } else {
+      mp[key] = i;
+      expected[key] = i;
+    }
+
+    if (i % 100 == 0) {
+      size_t k = mt() % (expected.size() + 1);
+      auto it = mp.Select(k);
+      if (k == expected.size()) {
+        ASSERT_EQ(it, mp.End());
+      } else {
+        ASSERT_EQ(it->first, std::next(expected.begin(), k)->first);
+      }
+
+      int lo = static_cast<int>(mt() % 3000);
+      int hi = static_cast<int>(mt() % 3000);
+      auto rank = static_cast<size_t>(std::distance(expected.begin(), expected.lower_bound(lo)));
+      ASSERT_EQ(mp.Rank(lo), rank);
+
+      size_t count = lo < hi ? std::distance(expected.lower_bound(lo), expected.lower_bound(hi)) : 0;
+      ASSERT_EQ(mp.CountInRange(lo, hi), count);
+    }
+  }
+}
+
+
+TEST_F(MapTest, AscendingDescendingViews) {
+  std::vector<int> keys;
+  for (const auto& [key, value] : mp.Ascending()) {
+    keys.push_back(key);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{-10, 0, 1, 3, 5, 10, 90}));
+
+  keys.clear();
+  for (const auto& [key, value] : mp.Descending()) {
+    keys.push_back(key);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{90, 10, 5, 3, 1, 0, -10}));
+
+  Map<int, int> empty;
+  ASSERT_TRUE(empty.Ascending().IsEmpty());
+  ASSERT_TRUE(empty.Descending().IsEmpty());
+}
+
+TEST(BalancedMapTest, DescendingAfterErasures) {
+  std::mt19937 mt(42);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+  for (int i = 0; i < 10000; ++i) {
+    int key = static_cast<int>(mt() % 5000);
+    if (i % 3 == 2 && expected.erase(key) == 1) {
+      mp.Erase(key);
+    } else {
+      mp[key] = i;
+      expected[key] = i;
+    }
+  }
+
+  auto view = mp.Descending();
+  ASSERT_TRUE(std::equal(view.begin(), view.end(), expected.rbegin(), expected.rend()));
+}
+
+
+TEST_F(MapTest, BidirectionalIterator) {
+  auto it = mp.End();
+  ASSERT_EQ((--it)->first, 90);
+  ASSERT_EQ((--it)->first, 10);
+  ASSERT_EQ((it--)->first, 10);
+  ASSERT_EQ(it->first, 5);
+  ASSERT_EQ((++it)->first, 10);
+
+  it = mp.Find(0);
+  ASSERT_EQ((--it)->first, -10);
+  ASSERT_EQ(it, mp.Begin());
+}
+
+TEST_F(MapTest, ReverseIterators) {
+  std::vector<int> keys;
+  for (auto it = mp.RBegin(); it != mp.REnd(); ++it) {
+    keys.push_back(it->first);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{90, 10, 5, 3, 1, 0, -10}));
+
+  auto it = mp.RBegin();
+  it->second = 42;
+  ASSERT_EQ(mp[90], 42);
+
+  it = mp.REnd();
+  ASSERT_EQ((--it)->first, -10);
+
+  Map<int, int> empty;
+  ASSERT_EQ(empty.RBegin(), empty.REnd());
+}
+
+
+TEST(ArenaMapTest, RandomOperations) {
+  std::mt19937 mt(7);
+  ArenaMap<int, int> mp;
+  std::map<int, int> expected;
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 20000; ++i) {
+      int key = static_cast<int>(mt() % 3000);
+      if (mt() % 3 == 0) {
+        if (expected.erase(key) == 1) {
+          mp.Erase(key);
+        }
+      } else {
+        mp[key] = i;
+        expected[key] = i;
+      }
+    }
+    ExpectSameContent(mp, expected);
+
+    // Slabs are freed at once, the map is usable afterwards
+    mp.Clear();
+    expected.clear();
+    ASSERT_TRUE(mp.IsEmpty());
+    ASSERT_EQ(mp.Begin(), mp.End());
+    ASSERT_EQ(mp.RBegin(), mp.REnd());
+  }
+}
+
+TEST(ArenaMapTest, NonTrivialElements) {
+  ArenaMap<std::string, std::string> mp;
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 5000; ++i) {
+    std::string key = fmt::format("key number {}", i * 7 % 5000);
+    mp[key] = std::string(40, static_cast<char>('a' + i % 26));
+    expected[key] = mp[key];
+  }
+  for (int i = 0; i < 5000; i += 3) {
+    std::string key = fmt::format("key number {}", i);
+    mp.Erase(key);
+    expected.erase(key);
+  }
+  ExpectSameContent(mp, expected);
+
+  // Destructors of strings still run: leaks are caught by the sanitizer
+  mp.Clear();
+  mp["again"] = "value";
+  ASSERT_EQ(mp.Size(), 1);
+}
+
+TEST(ArenaMapTest, Swap) {
+  ArenaMap<int, int> a;
+  ArenaMap<int, int> b;
+  for (int i = 0; i < 3000; ++i) {
+    a[i] = i;
+  }
+  b[-1] = -1;
+
+  std::swap(a, b);
+  ASSERT_EQ(a.Size(), 1);
+  ASSERT_EQ(b.Size(), 3000);
+  b.Erase(0);
+  a.Clear();
+  ASSERT_EQ(b.Begin()->first, 1);
+  ASSERT_EQ(b.Size(), 2999);
+}
+
+static int arena_releases = 0;
+
+template <typename T>
+class ReleaseCountingStorage: public ArenaStorage<T> {
+public:
+  void Release() noexcept {
+    ++arena_releases;
+    ArenaStorage<T>::Release();
+  }
+};
+
+// A map emptied by Erase still owns the slabs of the erased nodes:
+// Clear gives them back too
+TEST(ArenaMapTest, ClearAfterErase) {
+  Map<int, int, std::less<int>, ReleaseCountingStorage> mp;
+  for (int i = 0; i < 3000; ++i) {
+    mp[i] = i;
+  }
+  for (int i = 0; i < 3000; ++i) {
+    mp.Erase(i);
+  }
+  ASSERT_TRUE(mp.IsEmpty());
+
+  arena_releases = 0;
+  mp.Clear();
+  ASSERT_EQ(arena_releases, 1);
+  mp[1] = 1;
+  ASSERT_EQ(mp.Size(), 1);
+}
+
+
+TEST(BulkLoadTest, FromSorted) {
+  std::vector<std::pair<int, int>> sorted;
+  std::map<int, int> expected;
+  for (int i = 0; i < 10000; ++i) {
+    sorted.emplace_back(2 * i, i);
+    expected.emplace(2 * i, i);
+  }
+
+  auto mp = Map<int, int>::FromSorted(sorted.begin(), sorted.end());
+  ExpectSameContent(mp, expected);
+  for (size_t k = 0; k < sorted.size(); k += 997) {
+    ASSERT_EQ(mp.Select(k)->first, sorted[k].first);
+    ASSERT_EQ(mp.Rank(sorted[k].first), k);
+  }
+
+  // The tree stays a valid AVL tree for ordinary operations
+  for (int i = 0; i < 10000; i += 3) {
+    mp.Erase(2 * i);
+    expected.erase(2 * i);
+    mp.Insert({2 * i + 1, -i});
+    expected.emplace(2 * i + 1, -i);
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST(BulkLoadTest, FromSortedEdgeCases) {
+  std::vector<std::pair<int, int>> empty;
+  auto mp = Map<int, int>::FromSorted(empty.begin(), empty.end());
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(mp.Begin(), mp.End());
+
+  // Equal keys: the last value wins, as with Insert
+  std::vector<std::pair<int, int>> repeated = {{1, 1}, {1, 2}, {2, 3}, {2, 4}, {2, 5}};
+  mp = Map<int, int>::FromSorted(repeated.begin(), repeated.end());
+  ExpectSameContent(mp, std::map<int, int>{{1, 2}, {2, 5}});
+
+  std::vector<std::pair<const int, int>> one = {{42, 0}};
+  auto single = ArenaMap<int, int>::FromSorted(one.begin(), one.end());
+  ASSERT_EQ(single.Size(), 1);
+  ASSERT_EQ(single.Begin()->first, 42);
+  ASSERT_EQ(single.RBegin()->first, 42);
+}
+
+TEST(BulkLoadTest, BulkInsertMerges) {
+  std::mt19937 mt(3);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+
+  for (int round = 0; round < 20; ++round) {
+    std::map<int, int> batch;
+    for (int i = 0; i < 500; ++i) {
+      batch[static_cast<int>(mt() % 5000)] = round;
+    }
+    mp.BulkInsert(batch.begin(), batch.end());
+    for (const auto& [key, value]: batch) {
+      expected[key] = value;
+    }
+    ExpectSameContent(mp, expected);
+
+    for (int i = 0; i < 100; ++i) {
+      int key = static_cast<int>(mt() % 5000);
+      if (expected.erase(key) == 1) {
+        mp.Erase(key);
+      }
+    }
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST(BulkLoadTest, UnsortedInput) {
+  Map<int, int> mp;
+  mp.Insert({{2, 0}, {4, 0}});
+
+  std::vector<std::pair<int, int>> unsorted = {{1, 1}, {3, 3}, {2, 2}, {5, 5}};
+  ASSERT_THROW(mp.BulkInsert(unsorted.begin(), unsorted.end()), std::invalid_argument);
+  ExpectSameContent(mp, std::map<int, int>{{1, 1}, {2, 0}, {3, 3}, {4, 0}});
+}
+
+
+// Key that counts its constructions: transparent lookups must not make any
+struct CountedKey {
+  static inline size_t constructed = 0;
+
+  CountedKey() = default;
+
+  CountedKey(std::string_view name) : name(name) {
+    ++constructed;
+  }
+
+  std::string name;
+};
+
+struct CountedKeyLess {
+  using is_transparent = void;
+
+  static std::string_view Name(const CountedKey& key) {
+    return key.name;
+  }
+
+  static std::string_view Name(std::string_view name) {
+    return name;
+  }
+
+  template <typename A, typename B>
+  bool operator()(const A& a, const B& b) const {
+    return Name(a) < Name(b);
+  }
+};
+
+TEST(TransparentLookupTest, StringView) {
+  Map<std::string, int, std::less<>> mp;
+  mp.Insert({{"apple", 1}, {"banana", 2}, {"cherry", 3}});
+
+  std::string_view banana = "banana";
+  ASSERT_EQ(mp.Find(banana)->second, 2);
+  ASSERT_EQ(mp.Find("cherry")->second, 3);
+  ASSERT_EQ(mp.Find(std::string_view("date")), mp.End());
+  ASSERT_TRUE(mp.Contains("apple"));
+  ASSERT_FALSE(mp.Contains(std::string_view("apples")));
+
+  ASSERT_EQ(mp.LowerBound("b")->first, "banana");
+  ASSERT_EQ(mp.UpperBound(banana)->first, "cherry");
+  auto [first, last] = mp.EqualRange(banana);
+  ASSERT_EQ(std::distance(first, last), 1);
+
+  mp.Erase(banana);
+  ASSERT_FALSE(mp.Contains("banana"));
+  ASSERT_ANY_THROW(mp.Erase("banana"));
+  ASSERT_EQ(mp.Size(), 2);
+}
+
+TEST(TransparentLookupTest, NoTemporaryKeys) {
+  Map<CountedKey, int, CountedKeyLess> mp;
+  for (int i = 0; i < 100; ++i) {
+    mp[CountedKey(fmt::format("key {}", i))] = i;
+  }
+
+  size_t constructed = CountedKey::constructed;
+  for (int i = 0; i < 100; ++i) {
+    std::string name = fmt::format("key {}", i);
+    ASSERT_EQ(mp.Find(std::string_view(name))->second, i);
+    ASSERT_TRUE(mp.Contains(std::string_view(name)));
+    ASSERT_EQ(mp.LowerBound(std::string_view(name))->second, i);
+  }
+  mp.Erase(std::string_view("key 42"));
+  ASSERT_EQ(CountedKey::constructed, constructed);
+  ASSERT_FALSE(mp.Contains(std::string_view("key 42")));
+}
+
+TEST_F(MapTest, Contains) {
+  ASSERT_TRUE(mp.Contains(5));
+  ASSERT_FALSE(mp.Contains(6));
+}
+
+
+// Counts copies and moves of values
+struct Tracked {
+  static inline size_t copies = 0;
+  static inline size_t moves = 0;
+
+  Tracked(int value = 0) : value(value) {
+  }
+
+  Tracked(const Tracked& other) : value(other.value) {
+    ++copies;
+  }
+
+  Tracked(Tracked&& other) noexcept : value(other.value) {
+    ++moves;
+  }
+
+  Tracked& operator=(const Tracked& other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+
+  Tracked& operator=(Tracked&& other) noexcept {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+
+  int value;
+};
+
+TEST(EmplaceTest, TryEmplace) {
+  Map<std::string, std::string> mp;
+  auto [it, is_inserted] = mp.TryEmplace("key", 3, 'a');
+  ASSERT_TRUE(is_inserted);
+  ASSERT_EQ(it->second, "aaa");
+
+  // The value isn't touched for an existing key
+  std::string value = "other";
+  std::tie(it, is_inserted) = mp.TryEmplace("key", std::move(value));
+  ASSERT_FALSE(is_inserted);
+  ASSERT_EQ(it->second, "aaa");
+  ASSERT_EQ(value, "other");
+
+  std::string key(40, 'k');
+  mp.TryEmplace(std::move(key));
+  ASSERT_TRUE(key.empty());
+  ASSERT_EQ(mp[std::string(40, 'k')], "");
+}
+
+TEST(EmplaceTest, InsertOrAssign) {
+  Map<int, Tracked> mp;
+  Tracked::copies = Tracked::moves = 0;
+
+  auto [it, is_inserted] = mp.InsertOrAssign(1, Tracked(10));
+  ASSERT_TRUE(is_inserted);
+  std::tie(it, is_inserted) = mp.InsertOrAssign(1, Tracked(20));
+  ASSERT_FALSE(is_inserted);
+  ASSERT_EQ(it->second.value, 20);
+
+  mp.Insert(std::pair<const int, Tracked>(2, Tracked(30)));
+  ASSERT_EQ(mp.Find(2)->second.value, 30);
+  ASSERT_EQ(Tracked::copies, 0);
+}
+
+TEST(EmplaceTest, HintedInsert) {
+  Map<int, int> mp;
+  std::map<int, int> expected;
+
+  // Increasing keys before End(), decreasing before Begin()
+  for (int i = 0; i < 5000; ++i) {
+    auto it = mp.Insert(mp.End(), {i, i});
+    ASSERT_EQ(it->first, i);
+    expected[i] = i;
+  }
+  for (int i = -1; i > -5000; --i) {
+    auto it = mp.Insert(mp.Begin(), {i, i});
+    ASSERT_EQ(it->first, i);
+    expected[i] = i;
+  }
+  ExpectSameContent(mp, expected);
+
+  // Wrong hints and existing keys still work
+  std::mt19937 mt(5);
+  for (int i = 0; i < 5000; ++i) {
+    int key = static_cast<int>(mt() % 20000) - 10000;
+    auto hint = (i % 3 == 0) ? mp.End() : (i % 3 == 1) ? mp.Begin() : mp.Find(key / 2);
+    auto it = mp.Insert(hint, {key, -i});
+    ASSERT_EQ(*it, (std::pair<const int, int>(key, -i)));
+    expected[key] = -i;
+  }
+  ExpectSameContent(mp, expected);
+}
+
+TEST(EmplaceTest, HintsBetweenElements) {
+  Map<int, int> mp;
+  Map<int, int> other;
+  for (int i = 0; i < 2000; i += 2) {
+    mp[i] = i;
+    other[i + 1] = i;
+  }
+
+  // Right hints: the next element, from both ends of every gap
+  for (int i = 1; i < 2000; i += 4) {
+    auto it = mp.Insert(mp.Find(i + 1), {i, -i});
+    ASSERT_EQ(*it, (std::pair<const int, int>(i, -i)));
+  }
+  // A hint from another map or a stale key doesn't break anything
+  for (int i = 3; i < 2000; i += 4) {
+    auto it = mp.Insert(other.Find(i), {i, -i});
+    ASSERT_EQ(it->first, i);
+    ASSERT_EQ(mp.Insert(mp.Find(i - 1), {i, i})->second, i);
+  }
+
+  ASSERT_EQ(mp.Size(), 2000);
+  int expected = 0;
+  for (auto it = mp.Begin(); it != mp.End(); ++it) {
+    ASSERT_EQ(it->first, expected++);
+  }
+  ASSERT_EQ(other.Size(), 1000);
+}
+
+// A right hint is checked by two comparisons, appends need one
+TEST(EmplaceTest, HintedInsertComparisons) {
+  InstrumentedMap<int, int> mp;
+  for (int i = 0; i < 1000; ++i) {
+    mp.Insert(mp.End(), {2 * i, i});
+  }
+  ASSERT_EQ(mp.Stats().comparisons, 999);
+
+  mp.ResetStats();
+  for (int i = 1; i < 2000; i += 2) {
+    mp.Insert(mp.Find(i + 1), {i, i});
+  }
+  auto stats = mp.Stats();
+  mp.ResetStats();
+  for (int i = 1; i < 2000; i += 2) {
+    mp.Find(i + 1);
+  }
+  // Lookups of the hints compare up to twice a level, the insertions after
+  // them once a level plus two checks
+  size_t find_comparisons = mp.Stats().comparisons;
+  ASSERT_LE(stats.comparisons - find_comparisons, stats.node_visits - mp.Stats().node_visits + 2 * 1000);
+  ASSERT_EQ(mp.Size(), 2000);
+}
+
+// Random maps with overlapping keys and their std::map copies
+template <typename MapType>
+void FillRandom(MapType& mp, std::map<int, int>& expected, std::mt19937& mt, int sz, int value) {
+  for (int i = 0; i < sz; ++i) {
+    int key = static_cast<int>(mt() % (2 * sz));
+    mp[key] = value;
+    expected[key] = value;
+  }
+}
+
+TEST(SetOperationsTest, UnionIntersectDifference) {
+  std::mt19937 mt(11);
+  for (int sz: {0, 1, 10, 1000}) {
+    Map<int, int> lhs;
+    Map<int, int> rhs;
+    std::map<int, int> lhs_expected;
+    std::map<int, int> rhs_expected;
+    FillRandom(lhs, lhs_expected, mt, sz, 1);
+    FillRandom(rhs, rhs_expected, mt, sz / 2 + 1, 2);
+
+    // Equal keys take the value of the argument
+    std::map<int, int> united = rhs_expected;
+    united.insert(lhs_expected.begin(), lhs_expected.end());
+    std::map<int, int> common;
+    std::map<int, int> difference;
+    for (const auto& [key, value]: lhs_expected) {
+      (rhs_expected.contains(key) ? common : difference).emplace(key, value);
+    }
+
+    ExpectSameContent(lhs.Union(rhs), united);
+    ExpectSameContent(lhs.Intersect(rhs), common);
+    ExpectSameContent(lhs.Difference(rhs), difference);
+    ExpectSameContent(lhs.Union(Map<int, int>()), lhs_expected);
+    ExpectSameContent(lhs.Intersect(lhs), lhs_expected);
+    ASSERT_TRUE(lhs.Difference(lhs).IsEmpty());
+
+    // Arguments don't change, results are ordinary balanced maps
+    ExpectSameContent(lhs, lhs_expected);
+    ExpectSameContent(rhs, rhs_expected);
+    auto res = lhs.Union(rhs);
+    for (const auto& [key, value]: lhs_expected) {
+      res.Erase(key);
+      united.erase(key);
+    }
+    ExpectSameContent(res, united);
+  }
+}
+
+TEST(SetOperationsTest, Merge) {
+  std::mt19937 mt(12);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+
+  for (int round = 0; round < 10; ++round) {
+    Map<int, int> other;
+    std::map<int, int> other_expected;
+    FillRandom(other, other_expected, mt, 300, round);
+    mp.Merge(std::move(other));
+    for (const auto& [key, value]: other_expected) {
+      expected[key] = value;
+    }
+
+    ExpectSameContent(mp, expected);
+    ASSERT_TRUE(other.IsEmpty());
+    ASSERT_EQ(other.Begin(), other.End());
+    other[round] = round;
+    ASSERT_EQ(other.Size(), 1);
+  }
+
+  mp.Merge(std::move(mp));
+  ExpectSameContent(mp, expected);
+}
+
+TEST(SetOperationsTest, ArenaMerge) {
+  std::mt19937 mt(13);
+  ArenaMap<int, std::string> mp;
+  ArenaMap<int, std::string> other;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 2000; ++i) {
+    int key = static_cast<int>(mt() % 3000);
+    auto value = std::to_string(key) + " is a rather long string";
+    if (i % 2 == 0) {
+      mp[key] = value;
+      expected.emplace(key, value);
+    } else {
+      other[key] = value + "!";
+      expected[key] = value + "!";
+    }
+  }
+
+  // Nodes are copied out of the other arena, which is freed
+  mp.Merge(std::move(other));
+  ExpectSameContent(mp, expected);
+  ASSERT_TRUE(other.IsEmpty());
+}
+
+TEST(InstrumentationTest, CountsLookups) {
+  // 2^10 - 1 sorted keys make a perfect tree of height 10
+  std::vector<std::pair<int, int>> sorted;
+  for (int i = 0; i < (1 << 10) - 1; ++i) {
+    sorted.emplace_back(i, i);
+  }
+  auto mp = InstrumentedMap<int, int>::FromSorted(sorted.begin(), sorted.end());
+  ASSERT_EQ(mp.Stats().allocations, sorted.size());
+  ASSERT_EQ(mp.Stats().rotations, 0);
+
+  mp.ResetStats();
+  for (const auto& [key, value]: sorted) {
+    ASSERT_NE(mp.Find(key), mp.End());
+  }
+
+  auto stats = mp.Stats();
+  ASSERT_EQ(stats.lookups, sorted.size());
+  ASSERT_EQ(stats.max_depth, 10);
+  // Half of the nodes are leaves at depth 10, a quarter at depth 9...
+  ASSERT_NEAR(stats.AverageDepth(), 9.0, 0.05);
+  // One comparison to go left, two to go right or to find the key
+  ASSERT_GE(stats.comparisons, stats.node_visits + stats.lookups);
+  ASSERT_LE(stats.comparisons, 2 * stats.node_visits);
+  ASSERT_EQ(stats.allocations, 0);
+
+  mp.ResetStats();
+  ASSERT_EQ(mp.Stats().lookups, 0);
+  ASSERT_EQ(mp.Stats().ComparisonsPerLookup(), 0);
+}
+
+TEST(InstrumentationTest, CountsRotationsAndAllocations) {
+  InstrumentedMap<int, int> mp;
+  for (int i = 0; i < 1000; ++i) {
+    mp.Insert({i, i});
+  }
+
+  auto stats = mp.Stats();
+  ASSERT_EQ(stats.lookups, 1000);
+  ASSERT_EQ(stats.allocations, 1000);
+  // Increasing keys always go to the right spine, which is rotated all the time
+  ASSERT_GT(stats.rotations, 900);
+  ASSERT_LE(stats.max_depth, 15);
+
+  // Existing keys allocate nothing
+  mp.Insert({5, 5});
+  ASSERT_EQ(mp.Stats().allocations, 1000);
+  mp.Erase(5);
+  ASSERT_EQ(mp.Stats().lookups, 1002);
+}
+
+TEST(InstrumentationTest, DisabledByDefault) {
+  Map<int, int> mp;
+  for (int i = 0; i < 100; ++i) {
+    mp[i] = i;
+  }
+  ASSERT_EQ(mp.Stats().lookups, 0);
+  ASSERT_EQ(mp.Stats().comparisons, 0);
+  // NoInstrumentation takes no space
+  ASSERT_EQ(sizeof(Map<int, int>) + sizeof(CountingInstrumentation), sizeof(InstrumentedMap<int, int>));
+}
+
+TEST(EraseByIteratorTest, RandomOperations) {
+  std::mt19937 mt(21);
+  Map<int, int> mp;
+  std::map<int, int> expected;
+  for (int i = 0; i < 5000; ++i) {
+    int key = static_cast<int>(mt() % 3000);
+    mp[key] = i;
+    expected[key] = i;
+  }
+
+  for (int i = 0; i < 2000; ++i) {
+    int key = static_cast<int>(mt() % 3000);
+    auto it = mp.LowerBound(key);
+    auto expected_it = expected.lower_bound(key);
+    if (it == mp.End()) {
+      ASSERT_EQ(expected_it, expected.end());
+      continue;
+    }
+
+    auto next = mp.Erase(it);
+    auto expected_next = expected.erase(expected_it);
+    if (expected_next == expected.end()) {
+      ASSERT_EQ(next, mp.End());
+    } else {
+      ASSERT_EQ(*next, *expected_next);
+    }
+  }
+  ExpectSameContent(mp, expected);
+
+  // Erasing everything from the beginning
+  for (auto it = mp.Begin(); it != mp.End();) {
+    it = mp.Erase(it);
+  }
+  ASSERT_TRUE(mp.IsEmpty());
+}
+
+TEST(EraseByIteratorTest, WrongIterators) {
+  Map<int, int> mp;
+  Map<int, int> other;
+  for (int i = 0; i < 100; ++i) {
+    mp[i] = i;
+    other[i] = i;
+  }
+
+  ASSERT_THROW(mp.Erase(mp.End()), std::runtime_error);
+  ASSERT_THROW(mp.Erase(other.Find(42)), std::invalid_argument);
+  ASSERT_EQ(mp.Size(), 100);
+  ASSERT_EQ(other.Size(), 100);
+}
+
+TEST(EraseByIteratorTest, TransparentComparator) {
+  Map<std::string, int, std::less<>> mp;
+  mp["key"] = 1;
+  mp["other"] = 2;
+
+  mp.Erase(mp.Find("key"));
+  mp.Erase(std::string_view("other"));
+  ASSERT_TRUE(mp.IsEmpty());
+}
+
+// Stale iterators are checked in checked_iterators.cpp: here a use of one
+// is left to the sanitizers
+TEST(EraseByIteratorTest, UncheckedLayoutIsCompact) {
+  static_assert(sizeof(Map<int, int>::MapIterator) == sizeof(void*));
+  static_assert(sizeof(ArenaMap<int, int>::MapIterator) == sizeof(void*));
+}
+
+
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
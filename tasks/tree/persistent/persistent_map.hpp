@@ -0,0 +1,378 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace detail::persistent {
+
+// AVL tree of height 64 has more than 2^44 nodes
+inline constexpr size_t kMaxHeight = 64;
+
+}  // namespace detail::persistent
+
+// Immutable ordered map on an AVL tree with path copying.
+//
+// Insert and Erase don't change the map: they return a new version that
+// copies only the O(log n) nodes on the path to the key and shares all
+// other subtrees with the old one. Nodes are reference counted, so a subtree
+// lives while at least one version uses it. Copying a map is an O(1)
+// snapshot, and versions can be read from different threads.
+//
+// Unlike Map the tree isn't threaded: a shared node can't have a thread
+// to a successor, which differs from version to version.
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class PersistentMap {
+    class Node;
+
+    // Owning reference to an immutable node
+    class Ref {
+    public:
+        Ref() noexcept : node_(nullptr) {
+        }
+
+        explicit Ref(Node* node) noexcept : node_(node) {
+            Acquire();
+        }
+
+        Ref(const Ref& other) noexcept : node_(other.node_) {
+            Acquire();
+        }
+
+        Ref(Ref&& other) noexcept : node_(std::exchange(other.node_, nullptr)) {
+        }
+
+        Ref& operator=(Ref other) noexcept {
+            std::swap(node_, other.node_);
+            return *this;
+        }
+
+        ~Ref() {
+            if (node_ != nullptr && node_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete node_;
+            }
+        }
+
+        inline Node* Get() const noexcept {
+            return node_;
+        }
+
+        inline Node* operator->() const noexcept {
+            return node_;
+        }
+
+        inline explicit operator bool() const noexcept {
+            return node_ != nullptr;
+        }
+
+    private:
+        void Acquire() noexcept {
+            if (node_ != nullptr) {
+                node_->refs_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        Node* node_;
+    };
+
+public:
+    // Forward iterator: the current node on top of a stack of ancestors
+    // whose left subtrees are being visited, the next ones in order.
+    // Valid while the version it came from (or any copy of it) is alive
+    class MapIterator {
+        friend class PersistentMap;
+
+    public:
+        // NOLINTNEXTLINE
+        using value_type = std::pair<const Key, Value>;
+        // NOLINTNEXTLINE
+        using reference_type = const value_type&;
+        // NOLINTNEXTLINE
+        using pointer_type = const value_type*;
+        // NOLINTNEXTLINE
+        using difference_type = std::ptrdiff_t;
+        // NOLINTNEXTLINE
+        using iterator_category = std::forward_iterator_tag;
+
+        inline bool operator==(const MapIterator& other) const {
+            return Current() == other.Current();
+        };
+
+        inline bool operator!=(const MapIterator& other) const {
+            return Current() != other.Current();
+        };
+
+        inline reference_type operator*() const {
+            return Current()->data_;
+        };
+
+        inline pointer_type operator->() const {
+            return &Current()->data_;
+        };
+
+        MapIterator& operator++() {
+            Node* node = stack_[--size_];
+            PushLeftmost(node->right_.Get());
+            return *this;
+        };
+
+        MapIterator operator++(int) {
+            MapIterator copy = *this;
+            operator++();
+            return copy;
+        };
+
+    private:
+        inline Node* Current() const noexcept {
+            return size_ == 0 ? nullptr : stack_[size_ - 1];
+        }
+
+        inline void Push(Node* node) noexcept {
+            stack_[size_++] = node;
+        }
+
+        void PushLeftmost(Node* node) noexcept {
+            for (; node != nullptr; node = node->left_.Get()) {
+                Push(node);
+            }
+        }
+
+    private:
+        std::array<Node*, detail::persistent::kMaxHeight> stack_;
+        size_t size_ = 0;
+    };
+
+    PersistentMap() : sz_(0) {
+    }
+
+    explicit PersistentMap(const Compare& comp) : comp_(comp), sz_(0) {
+    }
+
+    PersistentMap(const std::initializer_list<std::pair<const Key, Value>>& values) : PersistentMap() {
+        for (const auto& val : values) {
+            *this = Insert(val);
+        }
+    }
+
+    inline bool IsEmpty() const noexcept {
+        return sz_ == 0;
+    }
+
+    inline size_t Size() const noexcept {
+        return sz_;
+    }
+
+    void Swap(PersistentMap& a) noexcept {
+        std::swap(comp_, a.comp_);
+        std::swap(root_, a.root_);
+        std::swap(sz_, a.sz_);
+    }
+
+    // New version with the pair inserted or the value replaced
+    PersistentMap Insert(const std::pair<const Key, Value>& val) const {
+        bool is_inserted = false;
+        Ref root = InsertAt(root_, val, is_inserted);
+        return PersistentMap(comp_, std::move(root), sz_ + (is_inserted ? 1 : 0));
+    }
+
+    // New version without the key
+    PersistentMap Erase(const Key& key) const {
+        Ref root = EraseAt(root_, key);
+        return PersistentMap(comp_, std::move(root), sz_ - 1);
+    }
+
+    MapIterator Find(const Key& key) const {
+        MapIterator it;
+        Node* node = root_.Get();
+
+        while (node != nullptr) {
+            if (comp_(key, node->data_.first)) {
+                it.Push(node);
+                node = node->left_.Get();
+            } else if (comp_(node->data_.first, key)) {
+                node = node->right_.Get();
+            } else {
+                it.Push(node);
+                return it;
+            }
+        }
+        return End();
+    }
+
+    inline MapIterator Begin() const noexcept {
+        MapIterator it;
+        it.PushLeftmost(root_.Get());
+        return it;
+    }
+
+    inline MapIterator End() const noexcept {
+        return MapIterator();
+    }
+
+    std::vector<std::pair<const Key, Value>> Values(bool is_increase = true) const {
+        std::vector<std::pair<const Key, Value>> res;
+        res.reserve(sz_);
+        for (auto it = Begin(); it != End(); ++it) {
+            res.push_back(*it);
+        }
+        if (is_increase) {
+            return res;
+        }
+
+        std::vector<std::pair<const Key, Value>> reversed;
+        reversed.reserve(sz_);
+        for (auto it = res.rbegin(); it != res.rend(); ++it) {
+            reversed.push_back(*it);
+        }
+        return reversed;
+    }
+
+    // Number of nodes this version shares with other: the nodes that
+    // are stored once for both of them
+    size_t SharedNodes(const PersistentMap& other) const {
+        std::vector<Node*> mine;
+        CollectNodes(root_.Get(), mine);
+        std::vector<Node*> theirs;
+        CollectNodes(other.root_.Get(), theirs);
+
+        std::unordered_set<Node*> seen(mine.begin(), mine.end());
+        return std::count_if(theirs.begin(), theirs.end(), [&seen](Node* node) { return seen.contains(node); });
+    }
+
+private:
+    class Node {
+        friend class PersistentMap;
+
+    public:
+        Node(const std::pair<const Key, Value>& data, Ref left, Ref right)
+            : left_(std::move(left)), right_(std::move(right)), data_(data) {
+            height_ = std::max(Height(left_), Height(right_)) + 1;
+        }
+
+    private:
+        std::atomic<size_t> refs_ = 0;
+        // Height of the subtree, 1 for a leaf
+        uint8_t height_;
+        Ref left_;
+        Ref right_;
+        const std::pair<const Key, Value> data_;
+    };
+
+    PersistentMap(const Compare& comp, Ref root, size_t sz) : comp_(comp), root_(std::move(root)), sz_(sz) {
+    }
+
+    static inline int Height(const Ref& node) noexcept {
+        return node ? node->height_ : 0;
+    }
+
+    static inline Ref Make(const std::pair<const Key, Value>& data, Ref left, Ref right) {
+        return Ref(new Node(data, std::move(left), std::move(right)));
+    }
+
+    // New node with the given children, rotated if their heights differ by 2.
+    // Rotations copy the nodes they change: the old ones may be shared
+    static Ref Balance(const std::pair<const Key, Value>& data, Ref left, Ref right) {
+        if (Height(left) > Height(right) + 1) {
+            if (Height(left->left_) >= Height(left->right_)) {
+                return Make(left->data_, left->left_, Make(data, left->right_, std::move(right)));
+            }
+            const Ref& mid = left->right_;
+            return Make(mid->data_, Make(left->data_, left->left_, mid->left_),
+                        Make(data, mid->right_, std::move(right)));
+        }
+
+        if (Height(right) > Height(left) + 1) {
+            if (Height(right->right_) >= Height(right->left_)) {
+                return Make(right->data_, Make(data, std::move(left), right->left_), right->right_);
+            }
+            const Ref& mid = right->left_;
+            return Make(mid->data_, Make(data, std::move(left), mid->left_),
+                        Make(right->data_, mid->right_, right->right_));
+        }
+
+        return Make(data, std::move(left), std::move(right));
+    }
+
+    // Copies of the nodes on the path, recursion depth is the tree height
+    Ref InsertAt(const Ref& node, const std::pair<const Key, Value>& val, bool& is_inserted) const {
+        if (!node) {
+            is_inserted = true;
+            return Make(val, Ref(), Ref());
+        }
+
+        if (comp_(val.first, node->data_.first)) {
+            return Balance(node->data_, InsertAt(node->left_, val, is_inserted), node->right_);
+        }
+        if (comp_(node->data_.first, val.first)) {
+            return Balance(node->data_, node->left_, InsertAt(node->right_, val, is_inserted));
+        }
+        return Make(val, node->left_, node->right_);
+    }
+
+    Ref EraseAt(const Ref& node, const Key& key) const {
+        if (!node) {
+            throw std::runtime_error("Value not found");
+        }
+
+        if (comp_(key, node->data_.first)) {
+            return Balance(node->data_, EraseAt(node->left_, key), node->right_);
+        }
+        if (comp_(node->data_.first, key)) {
+            return Balance(node->data_, node->left_, EraseAt(node->right_, key));
+        }
+
+        if (!node->left_) {
+            return node->right_;
+        }
+        if (!node->right_) {
+            return node->left_;
+        }
+
+        // The successor takes the place of the erased node
+        Node* successor = node->right_.Get();
+        while (successor->left_) {
+            successor = successor->left_.Get();
+        }
+        return Balance(successor->data_, node->left_, EraseMin(node->right_));
+    }
+
+    static Ref EraseMin(const Ref& node) {
+        if (!node->left_) {
+            return node->right_;
+        }
+        return Balance(node->data_, EraseMin(node->left_), node->right_);
+    }
+
+    static void CollectNodes(Node* node, std::vector<Node*>& nodes) {
+        if (node == nullptr) {
+            return;
+        }
+        nodes.push_back(node);
+        CollectNodes(node->left_.Get(), nodes);
+        CollectNodes(node->right_.Get(), nodes);
+    }
+
+private:
+    Compare comp_;
+    Ref root_;
+    size_t sz_;
+};
+
+namespace std {
+// Global swap overloading
+template <typename Key, typename Value, typename Compare>
+// NOLINTNEXTLINE
+void swap(PersistentMap<Key, Value, Compare>& a, PersistentMap<Key, Value, Compare>& b) {
+    a.Swap(b);
+}
+}  // namespace std
@@ -0,0 +1,116 @@
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+
+#include "../persistent_map.hpp"
+#include "../../iterators/map.hpp"
+
+// Bytes requested through operator new: memory taken by one version
+static size_t allocated_bytes = 0;
+
+void* operator new(size_t size) {
+  allocated_bytes += size;
+  if (void* memory = std::malloc(size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+// The replaced operator new allocates with malloc, GCC doesn't see it
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  std::free(memory);
+}
+#pragma GCC diagnostic pop
+
+PersistentMap<int, int> ConstructPersistentMap(int sz) {
+  PersistentMap<int, int> mp;
+  for (int i = 0; i < sz; ++i) {
+    mp = mp.Insert({i, i});
+  }
+  return mp;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// New version with one changed key, the old one stays as it is
+void BM_PersistentMapUpdate(benchmark::State& state) {
+  auto mp = ConstructPersistentMap(state.range(0));
+  std::mt19937 mt(42);
+
+  allocated_bytes = 0;
+  for (auto _ : state) {
+    auto version = mp.Insert({static_cast<int>(mt() % state.range(0)), 0});
+    benchmark::DoNotOptimize(version);
+  }
+  state.counters["bytes_per_version"] = static_cast<double>(allocated_bytes) / state.iterations();
+  state.SetComplexityN(state.range(0));
+}
+
+// The same with Map: the whole map is copied before the change
+void BM_MapCopyUpdate(benchmark::State& state) {
+  Map<int, int> mp;
+  for (int i = 0; i < state.range(0); ++i) {
+    mp[i] = i;
+  }
+  std::mt19937 mt(42);
+
+  allocated_bytes = 0;
+  for (auto _ : state) {
+    auto view = mp.Ascending();
+    auto version = Map<int, int>::FromSorted(view.begin(), view.end());
+    version[static_cast<int>(mt() % state.range(0))] = 0;
+    benchmark::DoNotOptimize(version);
+  }
+  state.counters["bytes_per_version"] = static_cast<double>(allocated_bytes) / state.iterations();
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_PersistentMapSnapshot(benchmark::State& state) {
+  auto mp = ConstructPersistentMap(state.range(0));
+
+  for (auto _ : state) {
+    auto snapshot = mp;
+    benchmark::DoNotOptimize(snapshot);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_PersistentMapErase(benchmark::State& state) {
+  auto mp = ConstructPersistentMap(state.range(0));
+  std::mt19937 mt(42);
+
+  allocated_bytes = 0;
+  for (auto _ : state) {
+    auto version = mp.Erase(static_cast<int>(mt() % state.range(0)));
+    benchmark::DoNotOptimize(version);
+  }
+  state.counters["bytes_per_version"] = static_cast<double>(allocated_bytes) / state.iterations();
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_PersistentMapFind(benchmark::State& state) {
+  auto mp = ConstructPersistentMap(state.range(0));
+  std::mt19937 mt(42);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mp.Find(static_cast<int>(mt() % state.range(0))));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+
+BENCHMARK(BM_PersistentMapUpdate)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_MapCopyUpdate)->Range(1<<10, 1<<20)->Complexity(benchmark::oN)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PersistentMapSnapshot)->Range(1<<10, 1<<20)->Complexity(benchmark::o1)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_PersistentMapErase)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_PersistentMapFind)->Range(1<<10, 1<<20)->Complexity(benchmark::oLogN)->Unit(benchmark::kNanosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include "../persistent_map.hpp"
+
+class PersistentMapTest: public testing::Test {
+  protected:
+    void SetUp() override {
+      mp = PersistentMap<int, int>({
+        {1, 5},
+        {3, 10},
+        {5, 90},
+        {10, -10},
+        {90, 0},
+        {-10, 5},
+        {0, 4}
+      });
+      ASSERT_EQ(mp.Size(), sz);
+    }
+
+  PersistentMap<int, int> mp;
+  const size_t sz = 7;
+};
+
+template <typename Key, typename Value>
+void ExpectSameContent(const PersistentMap<Key, Value>& mp, const std::map<Key, Value>& expected) {
+  ASSERT_EQ(mp.Size(), expected.size());
+
+  auto it = mp.Begin();
+  for (const auto& val: expected) {
+    ASSERT_NE(it, mp.End());
+    ASSERT_EQ(*it, val);
+    ++it;
+  }
+  ASSERT_EQ(it, mp.End());
+
+  auto values = mp.Values(false);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.rbegin(), expected.rend()));
+}
+
+
+TEST(EmptyPersistentMapTest, DefaultConstructor) {
+  PersistentMap<int, int> mp;
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(mp.Begin(), mp.End());
+  ASSERT_EQ(mp.Find(0), mp.End());
+  ASSERT_ANY_THROW(mp.Erase(0));
+}
+
+TEST(EmptyPersistentMapTest, StringAsKey) {
+  PersistentMap<std::string, std::string> mp;
+  auto first = mp.Insert({"key", "value"});
+  auto second = first.Insert({"key", "other"});
+
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(first.Find("key")->second, "value");
+  ASSERT_EQ(second.Find("key")->second, "other");
+  ASSERT_EQ(second.Size(), 1);
+}
+
+TEST_F(PersistentMapTest, Find) {
+  ASSERT_EQ(mp.Find(5)->second, 90);
+  ASSERT_EQ(mp.Find(6), mp.End());
+
+  // Iteration from a found element goes on in order
+  std::vector<int> keys;
+  for (auto it = mp.Find(1); it != mp.End(); ++it) {
+    keys.push_back(it->first);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{1, 3, 5, 10, 90}));
+}
+
+TEST_F(PersistentMapTest, OldVersionsDontChange) {
+  auto snapshot = mp;
+  auto inserted = mp.Insert({4, 4});
+  auto erased = inserted.Erase(5);
+
+  ExpectSameContent(snapshot, std::map<int, int>{{-10, 5}, {0, 4}, {1, 5}, {3, 10}, {5, 90}, {10, -10}, {90, 0}});
+  ExpectSameContent(inserted,
+                    std::map<int, int>{{-10, 5}, {0, 4}, {1, 5}, {3, 10}, {4, 4}, {5, 90}, {10, -10}, {90, 0}});
+  ExpectSameContent(erased, std::map<int, int>{{-10, 5}, {0, 4}, {1, 5}, {3, 10}, {4, 4}, {10, -10}, {90, 0}});
+}
+
+TEST_F(PersistentMapTest, EraseNotExistingValue) {
+  ASSERT_ANY_THROW(mp.Erase(42));
+  ASSERT_EQ(mp.Size(), sz);
+}
+
+TEST_F(PersistentMapTest, Swap) {
+  PersistentMap<int, int> other;
+  std::swap(mp, other);
+  ASSERT_TRUE(mp.IsEmpty());
+  ASSERT_EQ(other.Size(), sz);
+}
+
+// Every version is checked against its own copy of std::map
+TEST(VersionsTest, RandomOperations) {
+  std::mt19937 mt(42);
+  std::vector<PersistentMap<int, int>> versions(1);
+  std::vector<std::map<int, int>> expected(1);
+
+  for (int i = 0; i < 3000; ++i) {
+    size_t base = mt() % versions.size();
+    int key = static_cast<int>(mt() % 500);
+
+    if (mt() % 3 == 0 && expected[base].contains(key)) {
+      versions.push_back(versions[base].Erase(key));
+      expected.push_back(expected[base]);
+      expected.back().erase(key);
+    } else {
+      versions.push_back(versions[base].Insert({key, i}));
+      expected.push_back(expected[base]);
+      expected.back()[key] = i;
+    }
+  }
+
+  for (size_t v = 0; v < versions.size(); v += 37) {
+    ExpectSameContent(versions[v], expected[v]);
+  }
+  ExpectSameContent(versions.back(), expected.back());
+}
+
+// An update copies one path: O(log n) nodes, the rest are shared
+TEST(VersionsTest, UpdatesShareSubtrees) {
+  PersistentMap<int, int> mp;
+  for (int i = 0; i < 1 << 14; ++i) {
+    mp = mp.Insert({i, i});
+  }
+
+  auto updated = mp.Insert({12345, 0});
+  ASSERT_EQ(updated.Find(12345)->second, 0);
+  ASSERT_EQ(mp.Find(12345)->second, 12345);
+  ASSERT_GE(mp.SharedNodes(updated), mp.Size() - 2 * 15);
+
+  auto erased = mp.Erase(777);
+  ASSERT_GE(mp.SharedNodes(erased), mp.Size() - 3 * 15);
+}
+
+// Snapshots are read in other threads while the writer makes new versions
+TEST(VersionsTest, SnapshotsAcrossThreads) {
+  PersistentMap<int, int> mp;
+  std::vector<std::thread> readers;
+
+  for (int round = 0; round < 8; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      mp = mp.Insert({round * 1000 + i, round});
+    }
+    readers.emplace_back([snapshot = mp, round] {
+      ASSERT_EQ(snapshot.Size(), static_cast<size_t>(round + 1) * 1000);
+      int expected_key = 0;
+      for (const auto& [key, value]: snapshot.Values()) {
+        ASSERT_EQ(key, expected_key++);
+        ASSERT_EQ(value, key / 1000);
+      }
+    });
+    for (int i = 0; i < 1000; i += 2) {
+      mp = mp.Erase(round * 1000 + i).Insert({round * 1000 + i, round});
+    }
+  }
+
+  for (auto& reader: readers) {
+    reader.join();
+  }
+}
+
+
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}